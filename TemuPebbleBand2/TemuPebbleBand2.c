@@ -32,6 +32,20 @@
 
 // Include the VGA grahics library
 #include "vga16_graphics.h"
+// HUD number fields
+#include "hud.h"
+#include "fix15.h"
+#include "note_pool.h"
+#include "chart.h"
+#include "judge.h"
+#include "piano_scan.h"
+#include "keypad_scan.h"
+#include "input_events.h"
+#include "render_queue.h"
+#include "replay.h"
+#include "profiler.h"
+#include "coro_exec.h"
+#include "console.h"
 // Include standard libraries
 #include <stdio.h>
 #include <stdlib.h>
@@ -69,19 +83,10 @@
 #include "ASharp.h"
 #include "B.h"
 #include "HighC.h"
-#include "HighD.h"
+#include "highD.h"
 #include "amplitude_envelope_mario.h"
-
-// === the fixed point macros ========================================
-typedef signed int fix15;
-#define multfix15(a, b) ((fix15)((((signed long long)(a)) * ((signed long long)(b))) >> 15))
-#define float2fix15(a) ((fix15)((a) * 32768.0)) // 2^15
-#define fix2float15(a) ((float)(a) / 32768.0)
-#define absfix15(a) abs(a)
-#define int2fix15(a) ((fix15)(a << 15))
-#define fix2int15(a) ((int)(a >> 15))
-#define char2fix15(a) (fix15)(((fix15)(a)) << 15)
-#define divfix(a, b) (fix15)(div_s64s64((((signed long long)(a)) << 15), ((signed long long)(b))))
+#include "chart_fairy_fountain.h"
+#include "chart_twinkle.h"
 
 // Wall detection
 #define hitBottom(b) (b > int2fix15(360))
@@ -136,6 +141,20 @@ int data_chan;
 int ctrl_chan;
 dma_channel_config c2;
 
+// DAC sample rate; main() starts DMA timer 0 at sys_clk * 0x000B / 0xffff
+int audioRateHz = 20981;
+
+/**
+ * @brief Sets the rate DMA timer 0 sends samples to the DAC at, as sys_clk over a whole divisor
+ * @param hz at least sys_clk / 65535 (about 1.9 kHz)
+ */
+void audio_set_rate(int hz)
+{
+    uint32_t divisor = clock_get_hz(clk_sys) / hz;
+    dma_timer_set_fraction(0, 1, divisor);
+    audioRateHz = clock_get_hz(clk_sys) / divisor;
+}
+
 void play_sound()
 {
     // *thunk*
@@ -470,6 +489,8 @@ void play_b()
     }
 }
 
+void draw_fill_screen(char color); // forward declaration of the screen fill command
+
 void play_mario_death()
 {
     dma_channel_abort(data_chan); // abort the current transfer
@@ -494,7 +515,7 @@ void play_mario_death()
     dma_channel_wait_for_finish_blocking(data_chan);
 
     // write stuff to screen
-    fillRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, RED); // clear the screen
+    draw_fill_screen(RED); // clear the screen
 
     // bring back original config
     // stop ping ponging
@@ -528,14 +549,78 @@ int menu_selection = 0;         // 0 = play endless, 1 = play song with lives, 2
 int current_menu_selection = 0; // current menu selection
 int lives = -1;
 int numLanes = 13;
+extern bool pianoKeysPressed[13];
 void draw_piano(int lane, bool outline); // forward declaration of draw_piano function
 
+// ===============================
+// ====== render commands ========
+// ===============================
+// The game never draws directly: every change to the screen is queued (render_queue.h)
+// as one of these commands, carrying the values it needs, and the rendering core runs
+// it with the matching render_* function. The game owns notePool, the counters,
+// menu_state and the piano key states; the renderer owns the frame buffer, the text
+// cursor and the HUD fields. numLanes is only changed from the menu, before the game
+// screen is queued, so both sides read it.
+enum render_op
+{
+    RC_FILL_SCREEN,  // a = color
+    RC_MENU,         // menu picture and entries
+    RC_CURSOR,       // a = erase, b = menu selection
+    RC_CREDITS,      // credits screen
+    RC_END_SCREEN,   // x = notes hit, y = notes missed, w = max combo
+    RC_GAME_PICTURE, // game background picture
+    RC_BACKGROUND,   // lanes, HUD labels, piano; x = keys pressed, y = lanes with notes
+    RC_PIANO_KEY,    // a = lane, b = outline only; x = keys pressed, y = lane has notes
+    RC_HITLINE,      // hit area lines
+    RC_NOTE_RECT,    // b = color; x = top, y = height, w = left, h = width of a strip of a note column
+    RC_HUD,          // x = notes hit, y = notes missed, w = combo, h = max combo
+    RC_BANNER,       // a = BANNER_*
+    RC_HEART,        // a = index, b = 1 drawn, 0 erased
+    RC_FRAME,        // end of a game frame
+    RC_PROFILER,     // a = 1 draw the profiler overlay, 0 erase it
+    RC_PROF_RESET,   // forget the render stages' samples
+};
+
+// judgement banners
+#define BANNER_PERFECT 0
+#define BANNER_GOOD 1
+#define BANNER_BAD 2
+#define BANNER_MISS 3
+
+static void queue_cmd(uint8_t op, uint8_t a, uint8_t b, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    render_cmd cmd = {op, a, b, 0, x, y, w, h};
+    render_queue_push(&cmd);
+}
+
+void draw_fill_screen(char color)
+{
+    queue_cmd(RC_FILL_SCREEN, color, 0, 0, 0, 0, 0);
+}
+
+// piano keys held, bit k = key k
+static uint16_t pressed_keys()
+{
+    uint16_t pressed = 0;
+    for (int i = 0; i < 13; i++)
+    {
+        if (pianoKeysPressed[i])
+            pressed |= 1u << i;
+    }
+    return pressed;
+}
+
 // draw cursor on the menu given the current menu selection
 void draw_cursor(int erase)
+{
+    queue_cmd(RC_CURSOR, erase, menu_selection, 0, 0, 0, 0);
+}
+
+static void render_cursor(int erase, int selection)
 {
     // Draw the cursor on the screen
-    int x = 80;                          // x position of the cursor
-    int y = 320 + (menu_selection * 40); // y position of the cursor
+    int x = 80;                     // x position of the cursor
+    int y = 320 + (selection * 40); // y position of the cursor
     if (erase)
     {
         fillRect(x, y, 10, 10, BLACK); // erase the cursor on the screen
@@ -551,6 +636,11 @@ void draw_cursor(int erase)
 // ===========================
 
 void draw_credits()
+{
+    queue_cmd(RC_CREDITS, 0, 0, 0, 0, 0, 0);
+}
+
+static void render_credits()
 {
     // Draw the credits on the screen
     fillRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BLACK); // clear the screen
@@ -573,19 +663,10 @@ const int hitWidth = 40;                 // how tall the hit line is (hittable a
 int combo = 0;                           // combo counter for the number of notes hit in a row
 int maxCombo = 0;                        // max combo counter for the number of notes hit in a row
 
-typedef struct note
-{
-    int lane;     // which lane number it is in i.e. || 1 || 2  || 3 ||
-    float y;      // y position of the note (top edge of rectangle)
-    int height;   // height of the note -- used for sustaning notes
-    int color;    // ye (in form 0-15)
-    bool hit;     // if the note has been hit or not  - used for erasing the note as its hit
-    bool sustain; // if the note is a sustained note or not
-    // Maybe add start time and
-} note;
 // number of lanes
 
-const int gravity = 5;                                                  // The speed at which the notes fall -- can be changed to make it harder or easier
+fix15 gravity = float2fix15(5.0);                                       // The speed at which the notes fall in pixels per frame -- fractional speeds are fine
+const int frameTime = 30000;                                            // animation frame period in microseconds
 const int noteSkinniness = 2;                                           // offset for the notes to make them look better and be in the center of the lane
 volatile int numNotesHit = 0;                                           // number of notes hit
 volatile int numNotesMissed = 0;                                        // number of notes missed
@@ -593,11 +674,34 @@ const bool pianoKeyTypes[13] = {1, 0, 1, 0, 1, 1, 0, 1, 0, 1, 0, 1, 1}; // 1 is
 bool pianoKeysPressed[13] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 bool setup = false; // flag to check if the setup has been done
 
-volatile note notes[13][50];        // 3 lanes of notes, 50 is the max number of notes in each lane at a single time (arbitary large number)
-volatile int activeNotesInLane[13]; // number of notes in each lane
+// the falling notes live in notePool (note_pool.h)
+note_id heldSustain[13]; // the sustain each key is playing, or NOTE_NONE -- the only note a release lets go of
+
+// top edge of note n in whole pixels
+#define noteTop(n) fix2int15(notePool.y[n])
+
+/**
+ * @brief Whole pixels a note at y moves on its next update
+ * The fraction of gravity carries over in y, so a speed of 2.5 steps 2, 3, 2, 3...
+ */
+static inline int note_step(fix15 y)
+{
+    return fix2int15(y + gravity) - fix2int15(y);
+}
+
+// HUD value fields -- repaint only the digits that change
+hud_field hudNotesHit;
+hud_field hudNotesMissed;
+hud_field hudCombo;
+hud_field hudMaxCombo;
 
 // draw the main menu
 void draw_menu()
+{
+    queue_cmd(RC_MENU, 0, 0, 0, 0, 0, 0);
+}
+
+static void render_menu()
 {
     // fillRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BLACK); // clear the screen
     drawPicture(0, 0, (unsigned short *)vga_menu_image, 640, 480); // Draw the picture on the screen
@@ -613,16 +717,25 @@ void draw_menu()
     writeString("Credits");
 }
 
-void draw_piano(int lane, bool outline);
+static void render_piano(int lane, bool outline, uint16_t pressed, bool busy);
 
 /**
  * @brief Initializes the VGA display -- draws background.
  */
 void draw_background()
+{
+    uint16_t busy = 0;
+    for (int i = 0; i < numLanes; i++)
+    {
+        if (note_lane_count(i) > 0)
+            busy |= 1u << i;
+    }
+    queue_cmd(RC_BACKGROUND, 0, 0, pressed_keys(), busy, 0, 0);
+}
+
+static void render_background(uint16_t pressed, uint16_t busy)
 {
     // Draw vertical lines on the screen equally spaced away from the center
-    float offset = trackWidth / 2;
-    float singleTrackWidth = trackWidth / numLanes;
     // drawVLine(SCREEN_WIDTH/2 + offset, 0, SCREEN_HEIGHT, WHITE);
     // drawVLine(SCREEN_WIDTH / 2 - trackWidth / 2, 0, SCREEN_HEIGHT, WHITE);
     // Draws the track lines -- lines in between the two outer lines dictated by numLines
@@ -641,11 +754,16 @@ void draw_background()
     writeString("Combo: ");
     setCursor(10, 55);
     writeString("Max Combo: ");
+    // the values next to the labels are drawn by the animation loop
+    hud_init(&hudNotesHit, 130, 10, 2, WHITE, BLACK, 4);
+    hud_init(&hudNotesMissed, 170, 25, 2, WHITE, BLACK, 4);
+    hud_init(&hudCombo, 80, 40, 2, WHITE, BLACK, 4);
+    hud_init(&hudMaxCombo, 130, 55, 2, WHITE, BLACK, 4);
 
     // Draw a piano diagram on the screen
     for (int i = 0; i < numLanes; i++)
     {
-        draw_piano(i, 0); // draw the piano keys on the screen
+        render_piano(i, 0, pressed, (busy >> i) & 1); // draw the piano keys on the screen
     }
 
     // Draw black keys on the screen
@@ -659,12 +777,22 @@ void draw_background()
 }
 
 void draw_piano(int lane, bool outline)
+{
+    queue_cmd(RC_PIANO_KEY, lane, outline, pressed_keys(), note_lane_count(lane) > 0, 0, 0);
+}
+
+/**
+ * @brief Draws one piano key
+ * @param pressed keys held, bit k = key k
+ * @param busy the key's lane has notes in it
+ */
+static void render_piano(int lane, bool outline, uint16_t pressed, bool busy)
 {
     // Draw the piano keys on the screen
     int blackHeight = whiteHeight / 2; // height of the black key
     char keyColor;
     char outlineColor;
-    if (activeNotesInLane[lane] > 0)
+    if (busy)
     {
         outlineColor = MAGENTA;
     }
@@ -674,7 +802,7 @@ void draw_piano(int lane, bool outline)
     }
     if (pianoKeyTypes[lane]) // white key
     {
-        if (pianoKeysPressed[lane])
+        if ((pressed >> lane) & 1)
         {
             keyColor = RED;
         }
@@ -691,9 +819,9 @@ void draw_piano(int lane, bool outline)
                 fillRect(SCREEN_WIDTH / 2 - trackWidth / 2 + ((lane - 1) * trackWidth / numLanes) + trackWidth / (2 * numLanes) - 2, SCREEN_HEIGHT - whiteHeight + blackHeight, (trackWidth / numLanes) * 1 / 2 + 2, blackHeight, keyColor); // draw the note and bleed it into the next lane a bit
             }
             drawRect(SCREEN_WIDTH / 2 - trackWidth / 2 + ((lane - 1) * trackWidth / numLanes) + trackWidth / (2 * numLanes), SCREEN_HEIGHT - whiteHeight, (trackWidth / numLanes) * 2, whiteHeight, outlineColor); // draw the outline
-            char rightCOlor = (pianoKeysPressed[lane + 1]) ? GREEN : BLACK;
+            char rightCOlor = ((pressed >> (lane + 1)) & 1) ? GREEN : BLACK;
             drawVLine(SCREEN_WIDTH / 2 - trackWidth / 2 + ((lane - 1) * trackWidth / numLanes) + trackWidth / (2 * numLanes) + (trackWidth / numLanes) * 2 - 1, SCREEN_HEIGHT - whiteHeight, blackHeight, rightCOlor); // draw the outline
-            char leftCOlor = (pianoKeysPressed[lane - 1]) ? GREEN : BLACK;
+            char leftCOlor = ((pressed >> (lane - 1)) & 1) ? GREEN : BLACK;
             drawVLine(SCREEN_WIDTH / 2 - trackWidth / 2 + ((lane - 1) * trackWidth / numLanes) + trackWidth / (2 * numLanes), SCREEN_HEIGHT - whiteHeight, blackHeight, leftCOlor);
         }
         else if (lane != (numLanes - 1) && !(pianoKeyTypes[lane + 1])) // black key on the right
@@ -704,7 +832,7 @@ void draw_piano(int lane, bool outline)
                 fillRect(SCREEN_WIDTH / 2 - trackWidth / 2 + ((lane + 1) * trackWidth / numLanes) - 2, SCREEN_HEIGHT - whiteHeight + blackHeight, (trackWidth / numLanes) * 1 / 2 + 2, blackHeight, keyColor); // draw the note and bleed it into the next lane a bit
             }
             drawRect(SCREEN_WIDTH / 2 - trackWidth / 2 + (lane * trackWidth / numLanes), SCREEN_HEIGHT - whiteHeight, (trackWidth / numLanes) * 3 / 2 + 1, whiteHeight, outlineColor); // draw the outline
-            char rightCOlor = (pianoKeysPressed[lane + 1]) ? GREEN : BLACK;
+            char rightCOlor = ((pressed >> (lane + 1)) & 1) ? GREEN : BLACK;
             drawVLine(SCREEN_WIDTH / 2 - trackWidth / 2 + (lane * trackWidth / numLanes) + (trackWidth / numLanes) * 3 / 2, SCREEN_HEIGHT - whiteHeight, blackHeight, rightCOlor);
         }
         else if (lane != 0 && !(pianoKeyTypes[lane - 1])) // black key on the left
@@ -715,7 +843,7 @@ void draw_piano(int lane, bool outline)
                 fillRect(SCREEN_WIDTH / 2 - trackWidth / 2 + ((lane - 1) * trackWidth / numLanes) + trackWidth / (2 * numLanes) - 2, SCREEN_HEIGHT - whiteHeight + blackHeight, (trackWidth / numLanes) * 1 / 2 + 2, blackHeight, keyColor); // draw the note and bleed it into the next lane a bit
             }
             drawRect(SCREEN_WIDTH / 2 - trackWidth / 2 + ((lane - 1) * trackWidth / numLanes) + trackWidth / (2 * numLanes) - 1, SCREEN_HEIGHT - whiteHeight, (trackWidth / numLanes) * 3 / 2 + 3, whiteHeight, outlineColor); // draw the outline
-            char leftCOlor = (pianoKeysPressed[lane - 1]) ? GREEN : BLACK;
+            char leftCOlor = ((pressed >> (lane - 1)) & 1) ? GREEN : BLACK;
             drawVLine(SCREEN_WIDTH / 2 - trackWidth / 2 + ((lane - 1) * trackWidth / numLanes) + trackWidth / (2 * numLanes) - 1, SCREEN_HEIGHT - whiteHeight, blackHeight, leftCOlor);
         }
         else // no black key on either side
@@ -729,7 +857,7 @@ void draw_piano(int lane, bool outline)
     }
     else // black key
     {
-        if (pianoKeysPressed[lane])
+        if ((pressed >> lane) & 1)
         {
             keyColor = GREEN;
         }
@@ -743,9 +871,13 @@ void draw_piano(int lane, bool outline)
 }
 
 void draw_hitLine()
+{
+    queue_cmd(RC_HITLINE, 0, 0, 0, 0, 0, 0);
+}
+
+static void render_hitline()
 {
     // Draw the hit line -- the line that the notes must hit
-    int singleTrackWidth = trackWidth / numLanes;
     drawHLine(SCREEN_WIDTH / 2 - trackWidth / 2, SCREEN_HEIGHT - hitHeight, trackWidth, WHITE);
     drawHLine(SCREEN_WIDTH / 2 - trackWidth / 2, SCREEN_HEIGHT - hitHeight + hitWidth, trackWidth, WHITE);
 }
@@ -755,47 +887,56 @@ void draw_hitLine()
  * @param lane The lane to spawn the note in
  * @param color The color of the note
  * @param height The height of the note
+ * @param hitTime time_us_32() at which the note should be hit
  * @note Assumes that the lane is valid and that there is space in the lane
  */
-void spawn_note(int lane, int color, int height, int sustain)
-{
-    // Spawn a note in the given lane
-    if (activeNotesInLane[lane] < 50) // check if there is space in the lane
-    {
-        notes[lane][activeNotesInLane[lane]].lane = lane;
-        notes[lane][activeNotesInLane[lane]].y = -height; // spawn at the top of the screen
-        notes[lane][activeNotesInLane[lane]].height = height;
-        notes[lane][activeNotesInLane[lane]].color = color;
-        notes[lane][activeNotesInLane[lane]].hit = false;       // not hit yet
-        notes[lane][activeNotesInLane[lane]].sustain = sustain; // not a sustained note (long press note)
-        activeNotesInLane[lane]++;
+void spawn_note(int lane, int color, int height, int sustain, uint32_t hitTime)
+{
+    // Spawn a note in the given lane, just above the top of the screen
+    int n = note_pool_spawn(lane, -int2fix15(height), height, color, sustain, hitTime);
+    if (n >= 0) // check if there was space in the lane
+    {
         draw_piano(lane, 1); // draw the key on the screen
-        // printf("Spawned note in lane %d at y = %f, height = %d, color = %d\n", lane, notes[lane][activeNotesInLane[lane]].y, notes[lane][activeNotesInLane[lane]].height, notes[lane][activeNotesInLane[lane]].color); // print the note position for debugging
+        // printf("Spawned note in lane %d at y = %d, height = %d, color = %d\n", lane, noteTop(n), notePool.height[n], notePool.color[n]); // print the note position for debugging
     }
 }
 
+/**
+ * @brief Queues a strip of a lane's note column, from top, height pixels tall
+ * The column's place comes with the command, so the renderer reads no lane layout.
+ */
+static void queue_note_rect(int lane, int top, int height, char color)
+{
+    int left = SCREEN_WIDTH / 2 - trackWidth / 2 + (lane * trackWidth / numLanes) + noteSkinniness;
+    queue_cmd(RC_NOTE_RECT, 0, color, top, height, left, trackWidth / numLanes - noteSkinniness);
+}
+
 /**
  * @brief Draws the falling notes
  * @param erase 1 to erase the notes at their top edge, 2 to erase the note at the bottom edge, 3 to erase the whole note, 0 to draw them
  */
 void draw_notes(int erase)
 {
-    int singleTrackWidth = trackWidth / numLanes;
     // Draws the falling notes -- lines in between the two outer lines dictated by numLines
     for (int i = 0; i < numLanes; i++)
     {
-        for (int j = 0; j < activeNotesInLane[i]; j++)
+        for (int j = 0; j < note_lane_count(i); j++)
         {
+            note_id n = note_lane_id(i, j);
+            if (n == NOTE_NONE)
+            {
+                continue; // removed from the middle of the lane
+            }
             // Draw the note at its current position
             if (erase) // erase the note if needed
             {
                 if (erase == 1)
                 {                                                                                                                                                                      // erase only the top of the note that moved down
-                    fillRect(SCREEN_WIDTH / 2 - trackWidth / 2 + (i * trackWidth / numLanes) + noteSkinniness, notes[i][j].y, trackWidth / numLanes - noteSkinniness, gravity, BLACK); // erase the top of the note that moved down
+                    queue_note_rect(i, noteTop(n), note_step(notePool.y[n]), BLACK); // erase the top of the note that moved down
                 }
                 else
                 {                                                                                                                                                                                 // erase only the whole note
-                    fillRect(SCREEN_WIDTH / 2 - trackWidth / 2 + (i * trackWidth / numLanes) + noteSkinniness, notes[i][j].y, trackWidth / numLanes - noteSkinniness, notes[i][j].height, BLACK); // erase the whole note, subtract 10 to make it look better
+                    queue_note_rect(i, noteTop(n), notePool.height[n], BLACK); // erase the whole note, subtract 10 to make it look better
                 }
             }
             else
@@ -803,9 +944,27 @@ void draw_notes(int erase)
                 // FOR PIANO THIS IS FINE BUT FOR DRUM WE WILL NEED TO DELETE THE WHOLE NOTE ONCE IT IS HIT
                 // if (!notes[i][j].hit) { // dont move the note down if its been hit
                 // fillRect(SCREEN_WIDTH/2 - trackWidth/2 + (i*singleTrackWidth), notes[i][j].y, singleTrackWidth-5, notes[i][j].height, notes[i][j].color); // draw the whole note
-                fillRect(SCREEN_WIDTH / 2 - trackWidth / 2 + (i * trackWidth / numLanes) + noteSkinniness, notes[i][j].y + max(notes[i][j].height - gravity, 0), trackWidth / numLanes - noteSkinniness, gravity, notes[i][j].color); // draw the bottom of the note that moved down
+                queue_note_rect(i, noteTop(n) + max(notePool.height[n] - notePool.step[n], 0), notePool.step[n], notePool.color[n]); // draw the bottom of the note that moved down
                 // }
-                // printf("Note %d in lane %d at y = %f, height = %d, hit_satus = %d\n", j, i, notes[i][j].y, notes[i][j].height, notes[i][j].hit); // print the note position for debugging
+                // printf("Note %d in lane %d at y = %d, height = %d, flags = %d\n", j, i, noteTop(n), notePool.height[n], notePool.flags[n]); // print the note position for debugging
+            }
+        }
+    }
+}
+
+/**
+ * @brief Draws every falling note whole, for after steps that moved them undrawn
+ */
+static void redraw_notes()
+{
+    for (int i = 0; i < numLanes; i++)
+    {
+        for (int j = 0; j < note_lane_count(i); j++)
+        {
+            note_id n = note_lane_id(i, j);
+            if (n != NOTE_NONE)
+            {
+                queue_note_rect(i, noteTop(n), notePool.height[n], notePool.color[n]);
             }
         }
     }
@@ -814,34 +973,66 @@ void draw_notes(int erase)
 /**
  * @brief Erase a single note from the screen as it falls
  * @param lane The lane the note is in
- * @param noteIndex The index of the note in the lane (in activeNotesInLane)
+ * @param noteIndex The slot of the note in the lane (below note_lane_count(lane))
  */
 void erase_note(int lane, int noteIndex)
 {
-    int singleTrackWidth = trackWidth / numLanes;
     // Erase the note at its current position
     // fillRect(SCREEN_WIDTH/2 - trackWidth/2 + (lane*singleTrackWidth) + noteSkinniness/2, notes[lane][noteIndex].y + notes[lane][noteIndex].height - gravity, singleTrackWidth-noteSkinniness, gravity, BLACK);  // erase the bottom of the note that moved down
-    if (!notes[lane][noteIndex].sustain)
+    note_id n = note_lane_id(lane, noteIndex);
+    if (heldSustain[lane] == n)
+    {
+        heldSustain[lane] = NOTE_NONE; // played out while the key was still down
+    }
+    if (!(notePool.flags[n] & NOTE_SUSTAIN))
     {
-        fillRect(SCREEN_WIDTH / 2 - trackWidth / 2 + (lane * trackWidth / numLanes) + noteSkinniness, notes[lane][noteIndex].y, trackWidth / numLanes - noteSkinniness, notes[lane][noteIndex].height, BLACK);
+        queue_note_rect(lane, noteTop(n), notePool.height[n], BLACK);
     } // erase the whole note if it is not a sustained note
-    activeNotesInLane[lane]--;
-    notes[lane][noteIndex] = notes[lane][activeNotesInLane[lane]]; // Move the last note to the current position
-    if (activeNotesInLane[lane] <= 0)
+    note_pool_despawn(lane, noteIndex); // the rest of the lane stays in hit order
+    if (note_lane_count(lane) <= 0)
     {
         draw_piano(lane, 0); // draw the key on the screen
     }
 }
 
+/**
+ * @brief The note a press in this lane is judged against
+ * Lanes are kept in hit order, so this is the note at the lane's judge cursor. The cursor
+ * is first moved past notes already judged (a sustain being held included) and notes whose
+ * bad window had closed by time_us, which are only waiting to reach the miss line; it only
+ * moves forward, so each note is passed once.
+ * @param time_us time_us_32() of the press
+ */
+note_id next_note_to_hit(int lane, uint32_t time_us)
+{
+    while (!note_lane_judged_all(lane))
+    {
+        note_id n = note_lane_judged(lane);
+        if (n != NOTE_NONE && !(notePool.flags[n] & NOTE_JUDGED) &&
+            (int32_t)(time_us - notePool.hitTime[n]) <= (int32_t)judgeWindowUs[JUDGE_BAD])
+        {
+            return n;
+        }
+        note_lane_judge_next(lane);
+    }
+    return NOTE_NONE;
+}
+
 /**
  * @brief returns if the note is in the hit area
  */
-bool check_hit(note noteObj)
+bool check_hit(note_id n)
 {
-    return ((noteObj.y + noteObj.height) > (SCREEN_HEIGHT - hitHeight)) && ((noteObj.y + noteObj.height) < (SCREEN_HEIGHT - hitHeight + hitWidth));
+    int bottom = noteTop(n) + notePool.height[n];
+    return (bottom > (SCREEN_HEIGHT - hitHeight)) && (bottom < (SCREEN_HEIGHT - hitHeight + hitWidth));
 }
 
 void draw_end_screen()
+{
+    queue_cmd(RC_END_SCREEN, 0, 0, numNotesHit, numNotesMissed, maxCombo, 0);
+}
+
+static void render_end_screen(int notesHit, int notesMissed, int bestCombo)
 {
     // Draw the end screen on the screen
     fillRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BLACK); // clear the screen
@@ -850,126 +1041,226 @@ void draw_end_screen()
     setCursor(100, 100);
     writeString("Game Over");
     setTextSize(2);
-    char notesTextBuffer[4];
+    char notesTextBuffer[HUD_MAX_CHARS + 2];
 
     setCursor(50, 140);
     writeString("You hit: ");
     setCursor(150, 140);
-    sprintf(notesTextBuffer, "%d", numNotesHit);
+    hud_format_int(notesTextBuffer, notesHit);
     writeString(notesTextBuffer);
 
     setCursor(50, 180);
     writeString("You missed: ");
     setCursor(200, 180);
-    sprintf(notesTextBuffer, "%d", numNotesMissed);
+    hud_format_int(notesTextBuffer, notesMissed);
     writeString(notesTextBuffer);
 
     setCursor(50, 220);
     writeString("Your accuracy was: ");
     setCursor(270, 220);
-    if (numNotesHit + numNotesMissed > 0)
+    if (notesHit + notesMissed > 0)
     {
-        sprintf(notesTextBuffer, "%.2f", (float)numNotesHit / (numNotesHit + numNotesMissed));
+        // percentage with two decimals, kept as an integer (8750 -> "87.50%")
+        int len = hud_format_fixed(notesTextBuffer, notesHit * 10000 / (notesHit + notesMissed), 2);
+        notesTextBuffer[len] = '%';
+        notesTextBuffer[len + 1] = 0;
     }
     else
     {
-        sprintf(notesTextBuffer, "N/A"); // Handle the case where no notes are hit or missed
+        strcpy(notesTextBuffer, "N/A"); // Handle the case where no notes are hit or missed
     }
     writeString(notesTextBuffer);
 
     setCursor(50, 260);
     writeString("Your max combo was: ");
     setCursor(300, 260);
-    sprintf(notesTextBuffer, "%d", maxCombo);
+    hud_format_int(notesTextBuffer, bestCombo);
     writeString(notesTextBuffer);
 }
 
-int songLength = 45;
-static int twinkle_note = 0;
+/**
+ * @brief Draws (on) or erases a life heart
+ */
+void draw_heart(int index, bool on)
+{
+    queue_cmd(RC_HEART, index, on, 0, 0, 0, 0);
+}
+
+/**
+ * @brief Writes a judgement in the top right corner
+ */
+void draw_banner(int banner)
+{
+    queue_cmd(RC_BANNER, banner, 0, 0, 0, 0, 0);
+}
+
+static void render_banner(int banner)
+{
+    static const char *text[] = {"PERFECT!", "GOOD!!!!!", "BAD!!!!!!!!", "MISS!!!!"};
+    setCursor(SCREEN_WIDTH - 100, 10);
+    setTextColor2(WHITE, (banner == BANNER_PERFECT || banner == BANNER_GOOD) ? GREEN : RED);
+    setTextSize(2);
+    writeString((char *)text[banner]);
+}
+
+// profiler overlay, bottom right over the game picture
+#define PROF_OVERLAY_X 466
+#define PROF_OVERLAY_Y 388
+#define PROF_OVERLAY_FRAMES 16 // refreshed every this many game frames while shown
+#define PROF_OVERLAY_DIGITS 5  // width of each min/avg/max column, right-aligned
+bool profOverlay = false;      // toggled by keypad key 0 during a game
+
+/**
+ * @brief Writes a profiler time right-aligned in the overlay column starting column characters in
+ * Padded with spaces, so a shorter value covers a longer one drawn before it.
+ */
+static void render_profiler_value(int column, int y, uint32_t value)
+{
+    char digits[HUD_MAX_CHARS + 1];
+    char cell[HUD_MAX_CHARS + 1];
+    int len = hud_format_int(digits, (int)value);
+    int pad = (len < PROF_OVERLAY_DIGITS) ? PROF_OVERLAY_DIGITS - len : 0;
+    memset(cell, ' ', pad);
+    memcpy(cell + pad, digits, len + 1);
+    setCursor(PROF_OVERLAY_X + 6 * column, y);
+    writeString(cell);
+}
+
+/**
+ * @brief Draws each profiler stage's min/avg/max per frame, or blanks the overlay
+ * The picture under a blanked overlay comes back with the next game.
+ */
+static void render_profiler(bool show)
+{
+    if (!show)
+    {
+        fillRect(PROF_OVERLAY_X, PROF_OVERLAY_Y, SCREEN_WIDTH - PROF_OVERLAY_X, 8 * (PROF_STAGES + 1), BLACK);
+        return;
+    }
+    setTextColor2(WHITE, BLACK);
+    setTextSize(1);
+    setCursor(PROF_OVERLAY_X, PROF_OVERLAY_Y);
+    writeString("stage       min   avg   max");
+    for (int i = 0; i < PROF_STAGES; i++)
+    {
+        uint32_t lo, avg, hi;
+        prof_stats(i, &lo, &avg, &hi);
+        int y = PROF_OVERLAY_Y + 8 * (i + 1);
+        setCursor(PROF_OVERLAY_X, y);
+        writeString((char *)profStageNames[i]);
+        render_profiler_value(10, y, lo);
+        render_profiler_value(16, y, avg);
+        render_profiler_value(22, y, hi);
+    }
+}
+
+/**
+ * @brief Counts a note as missed: breaks the combo and takes a life
+ * @return true if that was the last life and the game is over
+ */
+static bool count_miss()
+{
+    numNotesMissed++; // increment the number of notes missed
+    judge_record(JUDGE_MISS, 0);
+    if (maxCombo < combo)
+    {
+        maxCombo = combo; // update the max combo counter
+    }
+    combo = 0;       // reset the combo counter
+    if (lives != -1) // if we are playing a song with lives
+    {
+        lives--; // decrement the number of lives
+        // erase the last heart on the screen
+        draw_heart(lives, 0); // erase the last heart
+
+        if (lives == 0)
+        {
+            play_mario_death(); // play the death sound
+            menu_state = 3;     // go back to the main menu
+            draw_end_screen();  // draw the end screen on the screen
+            setup = false;      // reset the setup flag
+            // clear notes
+            note_pool_reset(); // clear the notes in every lane
+
+            // stop dma channel
+            dma_channel_abort(data_chan); // abort the channel
+            dma_channel_abort(ctrl_chan); // abort the channel
+            return true;                  // return to the main menu
+        }
+    }
+
+    // write miss on the screen
+    draw_banner(BANNER_MISS);
+    return false;
+}
 
 /**
  * @brief Updates the falling notes
- * Currently just moves them down the screen and deletes them once we hit the bottom
+ * Moves them down the screen and removes them once they have been played or missed.
+ * Taps are removed when they are hit; a sustain shrinks while its key is held, and falls
+ * on out of the hit area if the key is let go.
+ * A note is missed by time, once its bad window has closed unplayed, as presses are
+ * judged by time; a note that reaches the bottom of the hit area before that (at high
+ * speeds or with wide windows) waits there for its window to close.
  */
 void update_notes()
 {
+    uint32_t now = time_us_32();
     // Update the falling notes -- move them down the screen
     for (int i = 0; i < numLanes; i++)
     {
-        for (int j = activeNotesInLane[i] - 1; j >= 0; j--)
+        for (int j = note_lane_count(i) - 1; j >= 0; j--)
         {
-            // Move the note down the screen
-            notes[i][j].y += gravity;
-
-            // if the bottom of the note is outside the hit area, make it smaller
-            if ((notes[i][j].y + notes[i][j].height) > (SCREEN_HEIGHT - hitHeight + hitWidth))
+            note_id n = note_lane_id(i, j);
+            if (n == NOTE_NONE)
             {
-                notes[i][j].height -= gravity; // make the note smaller
+                continue; // removed from the middle of the lane
             }
 
-            // If the note is off the screen, remove it from the lane
-            if (notes[i][j].y > SCREEN_HEIGHT - hitHeight + hitWidth)
+            // a note never hit is missed once its bad window has closed
+            if (!(notePool.flags[n] & NOTE_JUDGED) &&
+                (int32_t)(now - notePool.hitTime[n]) > (int32_t)judgeWindowUs[JUDGE_BAD])
             {
-                // Remove the note from the lane
                 erase_note(i, j);
-                numNotesMissed++; // increment the number of notes missed
-                if (maxCombo < combo)
+                if (count_miss())
+                {
+                    return; // out of lives: the notes are gone
+                }
+                continue; // skip the rest of the loop
+            }
+
+            // Move the note down the screen
+            fix15 y = notePool.y[n] + gravity;
+            int step = fix2int15(y) - noteTop(n);
+            int top = fix2int15(y);
+
+            // Past the hit area
+            if (top > SCREEN_HEIGHT - hitHeight + hitWidth)
+            {
+                if (notePool.flags[n] & NOTE_JUDGED)
                 {
-                    maxCombo = combo; // update the max combo counter
+                    erase_note(i, j); // played out, or a sustain let go of
                 }
-                combo = 0;       // reset the combo counter
-                if (lives != -1) // if we are playing a song with lives
+                else
                 {
-                    lives--; // decrement the number of lives
-                    // erase the last heart on the screen
-                    drawCharBig(10 + ((lives) * 20), 70, 0x14, WHITE, BLACK); // erase the last heart
-
-                    if (lives == 0)
-                    {
-                        play_mario_death(); // play the death sound
-                        menu_state = 3;     // go back to the main menu
-                        draw_end_screen();  // draw the end screen on the screen
-                        setup = false;      // reset the setup flag
-                        // clear notes
-                        for (int i = 0; i < 13; i++)
-                        {
-                            activeNotesInLane[i] = 0; // clear the notes in the lane
-                        }
-                        // reinitialize the notes
-                        for (int i = 0; i < 13; i++)
-                        {
-                            for (int j = 0; j < 50; j++)
-                            {
-                                notes[i][j].hit = false;            // reset the hit status of the note
-                                notes[i][j].sustain = false;        // reset the sustain status of the note
-                                notes[i][j].height = SCREEN_HEIGHT; // reset the height of the note
-                                notes[i][j].y = 0;                  // reset the y position of the note
-                                notes[i][j].lane = 0;               // reset the lane of the note
-                                notes[i][j].color = 0;              // reset the color of the note
-                            }
-                        }
-
-                        // stop dma channel
-                        dma_channel_abort(data_chan); // abort the channel
-                        dma_channel_abort(ctrl_chan); // abort the channel
-                        return;                       // return to the main menu
-                    }
+                    notePool.step[n] = 0; // still in its bad window: stays put until it closes
                 }
+                continue;
+            }
+            notePool.y[n] = y;
+            notePool.step[n] = step;
 
-                // write miss on the screen
-                setCursor(SCREEN_WIDTH - 100, 10);
-                setTextColor2(WHITE, RED);
-                setTextSize(2);
-                writeString("MISS!!!!");
-
-                continue; // skip the rest of the loop
+            // if the bottom of the note is outside the hit area, make it smaller
+            if ((top + notePool.height[n]) > (SCREEN_HEIGHT - hitHeight + hitWidth))
+            {
+                notePool.height[n] -= step; // make the note smaller
             }
 
             // If the note has been hit, make it smaller
-            if (notes[i][j].hit)
+            if (notePool.flags[n] & NOTE_HIT)
             {
-                notes[i][j].height -= gravity;                         // make the note smaller
-                if (notes[i][j].height <= 0 || (!notes[i][j].sustain)) // if the note is gone, remove it from the lane
+                notePool.height[n] -= notePool.step[n];                             // make the note smaller
+                if (notePool.height[n] <= 0 || !(notePool.flags[n] & NOTE_SUSTAIN)) // if the note is gone, remove it from the lane
                 {
                     erase_note(i, j);
                 }
@@ -978,75 +1269,104 @@ void update_notes()
     }
 }
 
-const unsigned int great_ff[35] = {11, 9, 8, 9, 9, 7, 6, 7, 7, 6, 5, 6, 6, 4, 3, 4, 11, 9, 8, 12, 11, 10, 11, 15, 12, 11, 12, 11, 9, 7, 6, 13, 13};
+// ========================================
+// ============ Song charts ===============
+// ========================================
+
+#define SAMPLE_HIGH_D 0 // chart sample ids
 
-// const unsigned int twinkle_twinkle[96] = {0, 13, 0, 13, 7, 13, 7, 13, 9, 13, 9, 13, 7, 7, 7, 13, 5, 13, 5, 13, 4, 13, 4, 13, 2, 13, 2, 13, 0, 0, 0, 13, 7, 13, 7, 13, 5, 13, 5, 13, 4, 13, 4, 13, 2, 2, 2, 13,
-//                                             7, 13, 7, 13, 5, 13, 5, 13, 4, 13, 4, 13, 2, 2, 2, 13, 0, 13, 0, 13, 7, 13, 7, 13, 9, 13, 9, 13, 7, 7, 7, 13, 5, 13, 5, 13, 4, 13, 4, 13, 2, 13, 2, 13, 0, 0, 0, 13};
-const unsigned int twinkle_twinkle1[45] = {0, 0, 7, 7, 9, 9, 7, 5, 5, 4, 4, 2, 2, 0, 7, 7, 5, 5, 4, 4, 2,
-                                           7, 7, 5, 5, 4, 4, 2, 0, 0, 7, 7, 9, 9, 7, 5, 5, 4, 4, 2, 2, 0, 13, 13, 13};
+const unsigned char *currentChart = chart_twinkle_twinkle; // chart played by the next game
+chart_cursor spawnCursor;                                  // next note to spawn (runs ahead by the fall time)
+chart_cursor songCursor;                                   // next sample or the end of the song (runs on time)
+bool chartPlaying = false;                                 // false until the chart thread opens currentChart for this game
+uint64_t songStartUs;                                      // time_us_64() at song time 0
 
-const unsigned int twinkle_twinkle2[35] = {11, 9, 8, 9, 9, 7, 6, 7, 7, 6, 5, 6, 6, 4, 3, 4, 11, 9, 8, 12, 11, 10, 11, 15, 12, 11, 12, 11, 9, 7, 6, 13, 13};
+/**
+ * @brief Microseconds a note takes to fall from spawning to the middle of the hit area
+ * Not rounded to whole frames, which would leave notes short of the hit area at speeds
+ * that do not divide the distance.
+ */
+int note_lead_us()
+{
+    return (int)(((long long)int2fix15(SCREEN_HEIGHT - hitHeight + hitWidth / 2) * frameTime) / gravity);
+}
 
-// 6, 13, 20, 27, 34, 41
-const unsigned int *twinkle_twinkle;
+/**
+ * @brief Height in pixels of a sustain lasting duration_us at the current scroll speed
+ */
+int sustain_height(uint32_t duration_us)
+{
+    int height = fix2int15((fix15)(((long long)duration_us * gravity) / frameTime));
+    return max(height, hitWidth);
+}
 
-static PT_THREAD(protothread_twinkle_notes(struct pt *pt))
+/**
+ * @brief Opens currentChart from the top, its time 0 one fall time from now
+ */
+void open_chart()
+{
+    chart_open(&spawnCursor, currentChart);
+    chart_open(&songCursor, currentChart);
+    songStartUs = time_us_64() + note_lead_us(); // a note at tick 0 spawns right away
+    chartPlaying = true;
+}
+
+/**
+ * @brief Plays the chart picked in the menu
+ * Notes spawn one fall time ahead of the moment they should be hit;
+ * samples and the end of the song happen on time.
+ */
+static PT_THREAD(protothread_chart_notes(struct pt *pt))
 {
     PT_BEGIN(pt);
-    const int maxHeight = SCREEN_HEIGHT / 4; // max height of the note
+    static const chart_event *ev;
+    static int64_t songTime;
     while (1)
     {
-        while (menu_state != 1 || twinkle_note == -1)
+        while (menu_state != 1)
         {
-            PT_YIELD_usec(100000); // Yield for 100ms
+            chartPlaying = false;
+            PT_YIELD_usec(10000); // Yield for 10ms, so a game started by start_game() spawns on time
         }
 
-        if (twinkle_note < songLength) // reset the note index
+        if (!chartPlaying)
         {
-            // Spawn notes every 100ms
-            int lane = twinkle_twinkle[twinkle_note]; // Random lane
-            int color = rand() % 16;                  // Random color
-            // int height = rand() % (maxHeight); // Random height
-            int sustain = 0;                                                                                                                                          // Random sustain (0 or 1)
-            if (songLength == 45 && (twinkle_note == 0 || twinkle_note == 6 || twinkle_note == 20 || twinkle_note == 27 || twinkle_note == 34 || twinkle_note == 41)) // if the note is a long note
+            open_chart(); // game started without start_game()
+        }
+        songTime = (int64_t)(time_us_64() - songStartUs);
+
+        // spawn every note that has to start falling by now
+        while ((ev = chart_peek(&spawnCursor))->kind != CHART_END && (int64_t)ev->time_us <= songTime + note_lead_us())
+        {
+            if (ev->kind == CHART_TAP && ev->lane < numLanes)
             {
-                sustain = 1; // make it a long note
+                spawn_note(ev->lane, rand() % 16, hitWidth, 0, (uint32_t)(songStartUs + ev->time_us)); // Random color
             }
-            int height = hitWidth; // Fixed height for now
-            if (sustain)
+            else if (ev->kind == CHART_SUSTAIN && ev->lane < numLanes)
             {
-                color = YELLOW;
-                height = 2 * hitWidth;
+                spawn_note(ev->lane, YELLOW, sustain_height(ev->duration_us), 1, (uint32_t)(songStartUs + ev->time_us));
             }
+            chart_advance(&spawnCursor);
+        }
 
-            if ((songLength == 35) && (twinkle_note == 23))
+        // samples and the end of the song
+        while ((int64_t)(ev = chart_peek(&songCursor))->time_us <= songTime)
+        {
+            if (ev->kind == CHART_END)
             {
-                play_HighD();
+                menu_state = 3;    // go back to the main menu
+                draw_end_screen(); // draw the end screen on the screen
+                setup = false;     // reset the setup flag
+                break;
             }
-            else
+            if (ev->kind == CHART_SAMPLE && ev->lane == SAMPLE_HIGH_D)
             {
-                spawn_note(lane, color, height, sustain);
+                play_HighD();
             }
+            chart_advance(&songCursor);
         }
 
-        // draw twinkle note number on the screen
-        // setCursor(10, 70);
-        // setTextColor2(WHITE, BLACK);
-        // setTextSize(2);
-        // char notesTextBuffer[4];
-        // sprintf(notesTextBuffer, "%d", twinkle_note);
-        // writeString(notesTextBuffer);
-
-        twinkle_note++;
-
-        if (twinkle_note >= songLength + 5)
-        {
-            menu_state = 3;    // go back to the main menu
-            draw_end_screen(); // draw the end screen on the screen
-            setup = false;     // reset the setup flag
-        }
-
-        PT_YIELD_usec(800000); // Yield for 100ms
+        PT_YIELD_usec(10000); // Yield for 10ms
     }
 
     PT_END(pt);
@@ -1058,9 +1378,130 @@ static PT_THREAD(protothread_twinkle_notes(struct pt *pt))
 // ========================================
 // ============ ANIMATION LOOP ============
 // ========================================
+// ========================================
+// ============ per-core load =============
+// ========================================
+
+// Core that runs the render commands: 1 to draw on the second core, 0 to draw on the
+// game core between ticks (as before the split), e.g. to compare the load reports
+#ifndef RENDER_CORE
+#define RENDER_CORE 1
+#endif
+
+// Each core only adds to its own counters, and core 0 reads them while core 1 runs, so they
+// are 32-bit (read whole) and never cleared from the other core: core_load_reset() notes where
+// they stand and the report counts from there.
+volatile uint32_t coreBusyUs[2];    // time in game ticks and rendering, per core; wraps every 71 minutes
+volatile unsigned int renderFrames; // game frames rendered, counted by RENDER_CORE
+uint32_t coreBusyStart[2];          // coreBusyUs at the last core_load_reset()
+unsigned int renderFramesStart;     // renderFrames at the last core_load_reset()
+uint64_t coreLoadStart;             // time_us_64() of the last core_load_reset()
+void core_load_reset();
+
+/**
+ * @brief Prints each core's busy share since core_load_reset(); the counts keep running
+ * Only game ticks and rendering are counted; input scanning and chart playback are a few
+ * microseconds per millisecond on top.
+ */
+void core_load_print()
+{
+    uint64_t elapsed = time_us_64() - coreLoadStart;
+    if (elapsed > 0)
+    {
+        for (int core = 0; core < 2; core++)
+        {
+            uint32_t busy = coreBusyUs[core] - coreBusyStart[core];
+            int permille = (int)((uint64_t)busy * 1000 / elapsed);
+            printf("core %d busy %d.%d%%", core, permille / 10, permille % 10);
+            printf(core ? "\n" : ", ");
+        }
+    }
+    printf("rendered %u frames, %u commands, deepest queue %u, %u full-queue stalls\n",
+           renderFrames - renderFramesStart, renderQueueStats.pushed, renderQueueStats.maxDepth, renderQueueStats.stalls);
+}
+
+/**
+ * @brief Starts counting core load from now
+ */
+void core_load_reset()
+{
+    coreBusyStart[0] = coreBusyUs[0];
+    coreBusyStart[1] = coreBusyUs[1];
+    renderFramesStart = renderFrames;
+    renderQueueStats.pushed = 0; // the queue's counts are kept by the game core
+    renderQueueStats.stalls = 0;
+    renderQueueStats.maxDepth = 0;
+    coreLoadStart = time_us_64();
+}
+
+// ========================================
+// ============ frame timing ==============
+// ========================================
+
+#define MAX_CATCHUP_STEPS 4 // steps drawn in one tick; any before them are run undrawn
+#define FRAME_LOG_LIMIT 8   // over-budget ticks logged per game; the rest are only counted
+
+int frameBudgetUs = 30000;      // game tick time that counts as an overrun (one frameTime)
+unsigned int frameSteps;        // simulation steps run
+unsigned int droppedFrames;     // steps run undrawn because the game fell too far behind
+unsigned int frameOverruns;     // ticks that took longer than frameBudgetUs
+uint32_t worstFrameUs;          // longest tick
+
+void frame_stats_reset();
+
+/**
+ * @brief Prints the step, drop and overrun counts since frame_stats_reset()
+ */
+void frame_stats_print()
+{
+    printf("frames: %u steps, %u dropped, %u over the %d us budget, worst tick %lu us\n", frameSteps,
+           droppedFrames, frameOverruns, frameBudgetUs, (unsigned long)worstFrameUs);
+}
+
+/**
+ * @brief Starts counting steps, drops and overruns from zero
+ */
+void frame_stats_reset()
+{
+    frameSteps = 0;
+    droppedFrames = 0;
+    frameOverruns = 0;
+    worstFrameUs = 0;
+}
+
+/**
+ * @brief Counts one game tick's time against the budget, logging the first few overruns
+ */
+static void frame_account(uint32_t tickUs)
+{
+    if (tickUs > worstFrameUs)
+    {
+        worstFrameUs = tickUs;
+    }
+    if (tickUs > (uint32_t)frameBudgetUs)
+    {
+        frameOverruns++;
+        if (frameOverruns <= FRAME_LOG_LIMIT)
+        {
+            printf("frame overrun: tick took %lu us, budget %d us\n", (unsigned long)tickUs, frameBudgetUs);
+        }
+    }
+}
+
+void dispatch_input(); // forward declaration of the input event handler
+
 static PT_THREAD(protothread_animation_loop(struct pt *pt))
 {
     PT_BEGIN(pt);
+    static uint64_t tickStart;
+    static uint64_t lastTick;      // when the accumulator was last topped up
+    static uint32_t stepDebtUs;    // game time owed to the simulation, run off in frameTime steps
+    static int steps;
+    static uint32_t profStart;
+    static unsigned int overlayFrame;
+    tickStart = time_us_64();
+
+    dispatch_input(); // key presses and releases since the last tick
 
     if (menu_state == 0)
     {
@@ -1085,8 +1526,18 @@ static PT_THREAD(protothread_animation_loop(struct pt *pt))
         {
             setup = true;
             draw_end_screen(); // Draw the credits on the screen
+            judge_print_session(); // timing report for the game that just ended
+            judge_reset_session();
+            debounce_print(&pianoDebounce, "piano");   // bounce counts so far, to tune the settle time
+            debounce_print(&keypadDebounce, "keypad");
+            input_events_print();
+            core_load_print();
+            frame_stats_print();
+            pt_stats_print(0); // thread run times and wake-up lateness on each core
+            pt_stats_print(1);
+            coro_exec_print();
+            replay_stop(); // the recording of this game is complete
 
-            twinkle_note = 0;   // reset the note index
             numNotesHit = 0;    // reset the number of notes hit
             numNotesMissed = 0; // reset the number of notes missed
             combo = 0;          // reset the combo counter
@@ -1094,23 +1545,7 @@ static PT_THREAD(protothread_animation_loop(struct pt *pt))
             // reset the lives
             lives = -1; // reset the lives
 
-            for (int i = 0; i < 13; i++)
-            {
-                activeNotesInLane[i] = 0; // clear the notes in the lane
-            }
-            // reinitialize the notes
-            for (int i = 0; i < 13; i++)
-            {
-                for (int j = 0; j < 50; j++)
-                {
-                    notes[i][j].hit = false;            // reset the hit status of the note
-                    notes[i][j].sustain = false;        // reset the sustain status of the note
-                    notes[i][j].height = SCREEN_HEIGHT; // reset the height of the note
-                    notes[i][j].y = 0;                  // reset the y position of the note
-                    notes[i][j].lane = 0;               // reset the lane of the note
-                    notes[i][j].color = 0;              // reset the color of the note
-                }
-            }
+            note_pool_reset(); // clear the notes in every lane
         }
     }
     else if (menu_state == 1)
@@ -1118,46 +1553,185 @@ static PT_THREAD(protothread_animation_loop(struct pt *pt))
         if (!setup)
         {
             setup = true;
-            drawPicture(0, 0, (unsigned short *)vga_image, 640, 480); // Draw the picture on the screen
+            core_load_reset(); // the load report covers this game
+            frame_stats_reset();
+            prof_reset(PROF_GAME_FIRST, PROF_GAME_LAST); // the profile and its overlay start from this game's first frame
+            queue_cmd(RC_PROF_RESET, 0, 0, 0, 0, 0, 0);   // the renderer's stages are its own to reset
+            pt_stats_reset(0);
+            pt_stats_reset(1);
+            lastTick = tickStart;
+            stepDebtUs = frameTime; // the first step runs right away
+            queue_cmd(RC_GAME_PICTURE, 0, 0, 0, 0, 0, 0); // Draw the picture on the screen
             draw_background();
 
             if (lives != -1) // if we are playing a song with lives
             {
                 for (int i = 0; i < lives; i++)
                 {
-                    drawCharBig(10 + (i * 20), 70, 0x14, RED, RED); // draw the heart on the screen
+                    draw_heart(i, 1); // draw the heart on the screen
                 }
             }
         }
-        draw_notes(1);
-        update_notes();
-        draw_notes(0);
+        // fixed timestep: the notes move one frameTime step for every frameTime that has
+        // passed, however long the ticks take, so a slow frame doesn't slow the song down
+        stepDebtUs += (uint32_t)(tickStart - lastTick);
+        lastTick = tickStart;
+        if (stepDebtUs >= (MAX_CATCHUP_STEPS + 1) * frameTime && menu_state == 1) // too far behind to draw every step
+        {
+            // the steps beyond the last MAX_CATCHUP_STEPS still move the notes, so they stay in
+            // time with the song and the judging; only their erasing and drawing is dropped
+            profStart = prof_begin();
+            draw_notes(3);
+            prof_end(PROF_ERASE, profStart);
+            profStart = prof_begin();
+            for (steps = 0; stepDebtUs >= (MAX_CATCHUP_STEPS + 1) * frameTime && menu_state == 1; steps++)
+            {
+                update_notes();
+                stepDebtUs -= frameTime;
+            }
+            prof_end(PROF_UPDATE, profStart);
+            profStart = prof_begin();
+            redraw_notes();
+            prof_end(PROF_DRAW, profStart);
+            frameSteps += steps;
+            droppedFrames += steps;
+        }
+        for (steps = 0; stepDebtUs >= frameTime && menu_state == 1; steps++)
+        {
+            profStart = prof_begin();
+            draw_notes(1);
+            prof_end(PROF_ERASE, profStart);
+            profStart = prof_begin();
+            update_notes();
+            prof_end(PROF_UPDATE, profStart);
+            profStart = prof_begin();
+            draw_notes(0);
+            prof_end(PROF_DRAW, profStart);
+            stepDebtUs -= frameTime;
+        }
+        frameSteps += steps;
+        profStart = prof_begin();
         draw_hitLine();
+        prof_end(PROF_HITLINE, profStart);
 
-        setTextColor2(WHITE, BLACK);
+        profStart = prof_begin();
+        queue_cmd(RC_HUD, 0, 0, numNotesHit, numNotesMissed, combo, maxCombo);
+        prof_end(PROF_HUD, profStart);
+        prof_commit(PROF_GAME_FIRST, PROF_GAME_LAST);
+        if (profOverlay && ++overlayFrame % PROF_OVERLAY_FRAMES == 0)
+        {
+            queue_cmd(RC_PROFILER, 1, 0, 0, 0, 0, 0);
+        }
+        queue_cmd(RC_FRAME, 0, 0, 0, 0, 0, 0);
 
-        char notesTextBuffer[4];
-        setCursor(130, 10);
-        sprintf(notesTextBuffer, "%d", numNotesHit);
-        writeString(notesTextBuffer);
+        coreBusyUs[get_core_num()] += (uint32_t)(time_us_64() - tickStart);
+        frame_account((uint32_t)(time_us_64() - tickStart));
+        PT_YIELD_UNTIL_usec(lastTick + (frameTime - stepDebtUs)); // until the next step is due
+    }
+    PT_END(pt);
+}
 
-        setCursor(170, 25);
-        sprintf(notesTextBuffer, "%d", numNotesMissed);
-        writeString(notesTextBuffer);
+// ========================================
+// ============ RENDERER ==================
+// ========================================
 
-        setCursor(80, 40);
-        sprintf(notesTextBuffer, "%d  ", combo);
-        writeString(notesTextBuffer);
+/**
+ * @brief Runs one render command against the frame buffer
+ */
+static void render_execute(const render_cmd *cmd)
+{
+    uint32_t start = prof_begin();
+    int stage = PROF_R_OTHER;
+    switch (cmd->op)
+    {
+    case RC_FILL_SCREEN:
+        fillRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, cmd->a);
+        break;
+    case RC_MENU:
+        render_menu();
+        break;
+    case RC_CURSOR:
+        render_cursor(cmd->a, cmd->b);
+        break;
+    case RC_CREDITS:
+        render_credits();
+        break;
+    case RC_END_SCREEN:
+        render_end_screen(cmd->x, cmd->y, cmd->w);
+        break;
+    case RC_GAME_PICTURE:
+        drawPicture(0, 0, (unsigned short *)vga_image, 640, 480);
+        break;
+    case RC_BACKGROUND:
+        render_background(cmd->x, cmd->y);
+        break;
+    case RC_PIANO_KEY:
+        render_piano(cmd->a, cmd->b, cmd->x, cmd->y);
+        break;
+    case RC_HITLINE:
+        render_hitline();
+        stage = PROF_R_HITLINE;
+        break;
+    case RC_NOTE_RECT:
+        fillRect(cmd->w, cmd->x, cmd->h, cmd->y, cmd->b);
+        stage = (cmd->b == BLACK) ? PROF_R_ERASE : PROF_R_NOTES;
+        break;
+    case RC_HUD:
+        hud_show_int(&hudNotesHit, cmd->x);
+        hud_show_int(&hudNotesMissed, cmd->y);
+        hud_show_int(&hudCombo, cmd->w);
+        hud_show_int(&hudMaxCombo, cmd->h);
+        stage = PROF_R_HUD;
+        break;
+    case RC_BANNER:
+        render_banner(cmd->a);
+        break;
+    case RC_HEART:
+        if (cmd->b)
+            drawCharBig(10 + (cmd->a * 20), 70, 0x14, RED, RED); // draw the heart
+        else
+            drawCharBig(10 + (cmd->a * 20), 70, 0x14, WHITE, BLACK); // erase the heart
+        break;
+    case RC_PROFILER:
+        render_profiler(cmd->a);
+        break;
+    case RC_PROF_RESET:
+        prof_reset(PROF_RENDER_FIRST, PROF_RENDER_LAST);
+        return;
+    case RC_FRAME:
+        renderFrames++;
+        prof_commit(PROF_RENDER_FIRST, PROF_RENDER_LAST); // this frame's render stages are done
+        return;
+    }
+    prof_end(stage, start);
+}
 
-        setCursor(130, 55);
-        sprintf(notesTextBuffer, "%d  ", maxCombo);
-        writeString(notesTextBuffer);
+/**
+ * @brief Draws whatever the game has queued
+ * The only thread that touches the frame buffer.
+ */
+static PT_THREAD(protothread_render(struct pt *pt))
+{
+    PT_BEGIN(pt);
+    static uint64_t drawStart;
 
-        PT_YIELD_usec(30000); // Yield for 30ms
+    while (1)
+    {
+        PT_YIELD_UNTIL(pt, render_queue_pending());
+        drawStart = time_us_64();
+        render_queue_drain();
+        coreBusyUs[get_core_num()] += (uint32_t)(time_us_64() - drawStart);
     }
     PT_END(pt);
 }
 
+// second core: nothing but the renderer
+void core1_main()
+{
+    pt_add_thread(protothread_render);
+    pt_schedule_start;
+}
+
 // ================================================================================================================
 // =====================================  END ANIMATION CODE ======================================================
 // ================================================================================================================
@@ -1166,195 +1740,217 @@ static PT_THREAD(protothread_animation_loop(struct pt *pt))
 // ========================================== BEGIN INPUT CODE ====================================================
 // ================================================================================================================
 
-// Keypad pin configurations
-#define BASE_KEYPAD_PIN 9
-#define KEYROWS 4
-#define NUMKEYS 12
-unsigned int keycodes[12] = {0x28, 0x11, 0x21, 0x41, 0x12, 0x22, 0x42, 0x14, 0x24, 0x44, 0x18, 0x48};
-unsigned int scancodes[4] = {0x01, 0x02, 0x04, 0x08};
-unsigned int button = 0x70;
-int prev_key = -1;
 int key_pressed = 0;
 
-void key_pressed_callback(int key); // forward declaration of the key callback function
-void key_released_callback();       // forward declaration of the key released callback function
+void key_pressed_callback(int key, uint32_t time_us); // forward declaration of the key callback function
+void key_released_callback();                         // forward declaration of the key released callback function
 
 // ===========================================
 // ============= KEYPAD CODE ================
 // ===========================================
 
-void key_pressed_callback_game(int key);  // forward declaration of the key callback function
-void key_released_callback_game(int key); // forward declaration of the key released callback function
-void key_pressed_callback(int key);       // forward declaration of the key callback function
-void key_released_callback(int key);      // forward declaration of the key released callback function
+void key_pressed_callback_game(int key, uint32_t time_us); // forward declaration of the key callback function
+void key_released_callback_game(int key);                  // forward declaration of the key released callback function
+void key_pressed_callback(int key, uint32_t time_us);      // forward declaration of the key callback function
+void key_released_callback(int key);                       // forward declaration of the key released callback function
+
+// Up to this many keypad edges are handled per drain; the rest wait for the next one
+#define KEYPAD_EDGE_BATCH (2 * KEYPAD_KEYS)
+
+// pt_event_signal() bits
+#define EVENT_KEYPAD (1u << 0) // the keypad interrupt queued a change
+#define EVENT_CORO (1u << 1)   // a coroutine event was signalled
+#define EVENT_CONSOLE (1u << 2) // characters arrived for the serial console
+
+/**
+ * @brief Keypad interrupt hook: wakes the keypad thread
+ */
+static void keypad_changed(void)
+{
+    pt_event_signal(EVENT_KEYPAD);
+}
 
 static PT_THREAD(protothread_keypad_scan(struct pt *pt))
 {
     // Initialize protothread and parameters
     PT_BEGIN(pt);
+    static key_edge edges[KEYPAD_EDGE_BATCH];
     static int i;
-    static uint32_t keypad;
+    static int n;
+
+    // the matrix is scanned by PIO and changes arrive by interrupt from here on
+    keypad_scan_init(keypad_changed);
 
-    // Main loop to handle keypad input
+    // Main loop to queue key edges for the game
     while (1)
     {
-        // Scan the keypad for a keypress
-        for (i = 0; i < KEYROWS; i++)
+        // one event per edge, for every key held, timed when the change was seen
+        n = keypad_scan_drain(edges, KEYPAD_EDGE_BATCH);
+        for (i = 0; i < n; i++)
         {
-            gpio_put_masked((0xF << BASE_KEYPAD_PIN), (scancodes[i] << BASE_KEYPAD_PIN));
-            sleep_us(1);
-            keypad = ((gpio_get_all() >> BASE_KEYPAD_PIN) & 0x7F);
-            if (keypad & button)
-                break;
-        }
-        // If a key is pressed, find the key code
-        if (keypad & button)
-        {
-            for (i = 0; i < NUMKEYS; i++)
-            {
-                if (keypad == keycodes[i])
-                    break;
-            }
-            if (i == NUMKEYS)
-                (i = -1);
-        }
-        // If no key is pressed, set i to -1
-        else
-        {
-            i = -1;
+            input_ring_push(&keypadEvents, INPUT_KEYPAD, &edges[i]); // handled by the game on its next tick
         }
 
-        // If a new key is pressed, "i" will be different than "prev_key"
-        // if (i != prev_key) {
-
-        // blink the LED if a key is pressed
-        if (i != -1 && prev_key == i)
+        // asleep until the interrupt sees a change, but back every millisecond
+        // while keys are settling, since only a drain finishes them
+        if (keypadDebounce.settling)
         {
-            key_pressed_callback(i); // Call the key callback function
-            key_pressed = 1;
+            PT_YIELD_EVENT_usec(EVENT_KEYPAD, 1000);
         }
-        else if (prev_key != i && key_pressed)
+        else
         {
-            key_released_callback(prev_key); // Call the key released callback function
-            key_pressed = 0;
+            PT_YIELD_EVENT(EVENT_KEYPAD);
         }
-        prev_key = i;
-        // }
-        // Yield for 30ms
-        PT_YIELD_usec(30000);
     }
     // End the protothread
     PT_END(pt);
 }
 
-// Mux Pins
-#define MUX_SEL0 2
-#define MUX_SEL1 3
-#define MUX_SEL2 4
-#define MUX_1 27
-#define MUX_2 28
-#define SIZE 13
-#define MUX_1_CHECK 8
-#define MUX_2_CHECK 5
-
-static unsigned int prev_keys2[13] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-bool prev_prev = false;
-static unsigned int prev_keys[13] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-static unsigned int curr_keys[13] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-static unsigned int new_keys[13] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+// Up to this many key edges are handled per drain; the rest wait for the next one
+#define PIANO_EDGE_BATCH (2 * PIANO_KEYS)
 
 static PT_THREAD(protothread_piano_scan(struct pt *pt))
 {
     // Initialize protothread and parameters
     PT_BEGIN(pt);
+    static key_edge edges[PIANO_EDGE_BATCH];
     static int i;
-    static int val_1;
-    static int val_2;
-    static int ind;
-
-    gpio_init(MUX_SEL0);
-    gpio_set_dir(MUX_SEL0, GPIO_OUT);
-    gpio_put(MUX_SEL0, 0);
-
-    gpio_init(MUX_SEL1);
-    gpio_set_dir(MUX_SEL1, GPIO_OUT);
-    gpio_put(MUX_SEL1, 0);
-
-    gpio_init(MUX_SEL2);
-    gpio_set_dir(MUX_SEL2, GPIO_OUT);
-    gpio_put(MUX_SEL2, 0);
-
-    gpio_init(MUX_1);
-    gpio_set_dir(MUX_1, GPIO_IN);
-    gpio_pull_down(MUX_1);
+    static int n;
 
-    gpio_init(MUX_2);
-    gpio_set_dir(MUX_2, GPIO_IN);
-    gpio_pull_down(MUX_2);
+    // the keys are scanned by PIO into a DMA ring from here on
+    piano_scan_init();
 
-    // Main loop to handle keypad input
+    // Main loop to queue key edges for the game
     while (1)
     {
+        // every edge carries the time of the scan that saw it, so a late drain
+        // delays the callback but not the timing the press is judged on
+        n = piano_scan_drain(edges, PIANO_EDGE_BATCH);
+        for (i = 0; i < n; i++)
+        {
+            input_ring_push(&pianoEvents, INPUT_PIANO, &edges[i]); // handled by the game on its next tick
+        }
 
-        // scan through all of the options to see which one is pressed
-        // see if the pressed ones are not pressed in previous check
-        // if it is new, "key_pressed_callback(i);" on the new one
-        // if it is not pressed anymore, "key_released_callback(i);" on it
+        PT_YIELD_usec(1000);
+    }
+    // End the protothread
+    PT_END(pt);
+}
 
-        // Scan all of the keyboard keys if they are pressed
-        for (int i = 0; i < 8; i++)
-        {
-            gpio_put(MUX_SEL0, (i >> 0) & 1);
-            gpio_put(MUX_SEL1, (i >> 1) & 1);
-            gpio_put(MUX_SEL2, (i >> 2) & 1);
+// ===========================================
+// ========= GAME START AND REPLAY ===========
+// ===========================================
 
-            sleep_us(5);
+bool recordGames = true; // start_game() records the game, for replay_game()
 
-            int val_1 = gpio_get(MUX_1); // read the value of the first mux pin
+/**
+ * @brief Sets up a game for a menu selection and starts its chart
+ * @param seed rand() seed, so a replay gets the same note colours
+ */
+static void begin_game(int selection, uint32_t seed)
+{
+    lives = (selection == 1) ? 3 : -1; // the second entry plays with lives
+    numLanes = 13;
+    currentChart = (selection == 2) ? chart_twinkle_twinkle : chart_great_fairy_fountain; // Set the song to play
+    srand(seed);
+    memset(heldSustain, NOTE_NONE, sizeof(heldSustain)); // the ids of the last game's notes mean nothing now
+    open_chart();       // start it from the top
+    menu_state = 1;     // Start the game
+    draw_background();  // Draw the background for the game
+    draw_hitLine();     // Draw the hit line for the game
+    setup = false;      // reset the setup flag
+}
 
-            if (i == 6)
-            {
-                curr_keys[7] = val_1;
-            }
-            else if (i == 7)
-            {
-                curr_keys[6] = val_1;
-            }
-            else
-            {
-                curr_keys[i] = val_1; // store the value in the current keys array
-            }
+/**
+ * @brief Starts the game for a menu selection (0 endless, 1 with lives, 2 second song) and records it
+ */
+void start_game(int selection)
+{
+    uint32_t seed = time_us_32();
+    begin_game(selection, seed);
+    if (recordGames)
+    {
+        replay_record_start(selection, lives, seed);
+        // the console can change these between games
+        replay_record_setting(REPLAY_SET_GRAVITY, (uint32_t)gravity);
+        replay_record_setting(REPLAY_SET_PERFECT, judgeWindowUs[JUDGE_PERFECT]);
+        replay_record_setting(REPLAY_SET_GOOD, judgeWindowUs[JUDGE_GOOD]);
+        replay_record_setting(REPLAY_SET_BAD, judgeWindowUs[JUDGE_BAD]);
+    }
+}
 
-            if (i < MUX_2_CHECK)
-            {
-                int val_2 = gpio_get(MUX_2); // read the value of the second mux pin
-                int ind = i + 8;
-                curr_keys[ind] = val_2; // store the value in the current keys array
-            }
+/**
+ * @brief Plays the last recorded game back through the key callbacks
+ * The scroll speed and judging windows are set to the recorded ones and stay so afterwards.
+ * @return false if there is no complete recording to play
+ */
+bool replay_game()
+{
+    replay_record start;
+    int setting;
+    uint32_t value;
+    if (!replay_begin(&start))
+    {
+        printf("replay: no recorded game\n");
+        return false;
+    }
+    while (replay_next_setting(&setting, &value))
+    {
+        if (setting == REPLAY_SET_GRAVITY)
+        {
+            gravity = (fix15)value; // before begin_game(): the chart's lead time depends on it
         }
-
-        for (int i = 0; i < SIZE; i++)
+        else if (setting >= REPLAY_SET_PERFECT && setting <= REPLAY_SET_BAD)
         {
-            if (curr_keys[i] != prev_keys[i])
-            {
-                if (curr_keys[i] == 1)
-                {
-                    key_pressed_callback(i + 1); // Call the key callback function
-                    key_pressed = 1;
-                }
-                else
-                {
-                    key_released_callback(i + 1); // Call the key released callback function
-                    key_pressed = 0;
-                }
-            }
-            prev_keys[i] = curr_keys[i]; // Copy the current keys to the previous keys for the next iteration
+            judgeWindowUs[JUDGE_PERFECT + setting - REPLAY_SET_PERFECT] = value;
         }
+    }
+    begin_game(start.source, start.time_us);
+    lives = (int8_t)start.key; // as recorded
+    return true;
+}
 
-        PT_YIELD_usec(30000);
+/**
+ * @brief Hands one input event to the key callbacks
+ */
+static void deliver_input(const input_event *ev)
+{
+    int key = (ev->source == INPUT_PIANO) ? ev->key + 1 : ev->key; // piano keys are numbered from 1
+    if (ev->down)
+    {
+        key_pressed_callback(key, ev->time_us); // Call the key callback function
+        key_pressed = 1;
+    }
+    else
+    {
+        key_released_callback(key); // Call the key released callback function
+        key_pressed = 0;
+    }
+}
+
+/**
+ * @brief Hands every queued input event to the key callbacks, oldest first
+ * Called once per tick by the animation loop, so the callbacks' drawing never holds up a scan.
+ * While a recorded game plays back, live input is dropped and the recorded edges that are
+ * due are delivered instead, with their timestamps put back relative to the song.
+ */
+void dispatch_input()
+{
+    input_event ev;
+    while (input_events_next(&ev))
+    {
+        if (replay_playing())
+        {
+            continue;
+        }
+        replay_record_event(&ev, (int32_t)(ev.time_us - (uint32_t)songStartUs)); // if a game is being recorded
+        deliver_input(&ev);
+    }
+    while (replay_next((int32_t)(time_us_32() - (uint32_t)songStartUs), &ev))
+    {
+        ev.time_us += (uint32_t)songStartUs;
+        deliver_input(&ev);
     }
-    // End the protothread
-    PT_END(pt);
 }
 
 /**
@@ -1362,7 +1958,7 @@ static PT_THREAD(protothread_piano_scan(struct pt *pt))
  */
 void key_released_callback(int key)
 {
-    // printf("Key released: %d\n", prev_key); // Print the key released for debugging
+    // printf("Key released: %d\n", key); // Print the key released for debugging
     if (menu_state == 1) // if we are in the game
     {
         key_released_callback_game(key); // Call the key released callback function
@@ -1370,23 +1966,7 @@ void key_released_callback(int key)
     else if (menu_state == 0) // if we are in the menu
     {
 
-        for (int i = 0; i < 13; i++)
-        {
-            activeNotesInLane[i] = 0; // clear the notes in the lane
-        }
-        // reinitialize the notes
-        for (int i = 0; i < 13; i++)
-        {
-            for (int j = 0; j < 50; j++)
-            {
-                notes[i][j].hit = false;            // reset the hit status of the note
-                notes[i][j].sustain = false;        // reset the sustain status of the note
-                notes[i][j].height = SCREEN_HEIGHT; // reset the height of the note
-                notes[i][j].y = 0;                  // reset the y position of the note
-                notes[i][j].lane = 0;               // reset the lane of the note
-                notes[i][j].color = 0;              // reset the color of the note
-            }
-        }
+        note_pool_reset(); // clear the notes in every lane
 
         if (key == 1)
         {
@@ -1402,43 +1982,28 @@ void key_released_callback(int key)
         }
         else if (key == 3)
         {
-            if (menu_selection == 0)
-            {
-                menu_state = 1; // Start the game
-                numLanes = 13;
-                twinkle_twinkle = twinkle_twinkle2; // Set the song to play
-                songLength = 35;                    // Set the song length
-                draw_background();                  // Draw the background for the game
-                draw_hitLine();                     // Draw the hit line for the game
-                setup = false;                      // reset the setup flag
-            }
-            else if (menu_selection == 1)
-            {
-                menu_state = 1; // Start the game with lives
-                lives = 3;
-                numLanes = 13;
-                twinkle_twinkle = twinkle_twinkle2; // Set the song to play
-                songLength = 35;                    // Set the song length
-                draw_background();                  // Draw the background for the game
-                draw_hitLine();                     // Draw the hit line for the game
-                setup = false;                      // reset the setup flag
-            }
-            else if (menu_selection == 2)
-            {
-                twinkle_twinkle = twinkle_twinkle1; // Set the song to play
-                songLength = 45;                    // Set the song length
-                menu_state = 1;                     // Start the game with 12 lanes
-                numLanes = 13;                      // Set the number of lanes to 12
-                draw_background();                  // Draw the background for the game
-                draw_hitLine();                     // Draw the hit line for the game
-                setup = false;                      // reset the setup flag
-            }
-            else if (menu_selection == 3)
+            if (menu_selection == 3)
             {
                 menu_state = 2; // Show credits
                 draw_credits(); // Draw the credits on the screen
                 setup = false;  // reset the setup flag
             }
+            else
+            {
+                start_game(menu_selection); // Start the game picked
+            }
+        }
+        else if (key == 4)
+        {
+            replay_game(); // play the last game back
+        }
+        else if (key == 5)
+        {
+            replay_dump(); // print the last game's recording
+        }
+        else if (key == 6)
+        {
+            prof_dump_csv(); // print the frame profile of the last game
         }
     }
     else if (menu_state == 2 || menu_state == 3) // if we are in the credits
@@ -1451,20 +2016,28 @@ void key_released_callback(int key)
 
 /**
  * @brief callback for key press
+ * @param time_us time_us_32() when the press was seen
  */
-void key_pressed_callback(int key)
+void key_pressed_callback(int key, uint32_t time_us)
 {
     if (menu_state == 1) // if we are in the game
     {
-        key_pressed_callback_game(key); // Call the key callback function
+        key_pressed_callback_game(key, time_us); // Call the key callback function
     }
 }
 
 /**
  * @brief callback for key press while playing the game
+ * The press is graded by its timestamp against the note's scheduled hit time (judge.h).
  */
-void key_pressed_callback_game(int key)
+void key_pressed_callback_game(int key, uint32_t time_us)
 {
+    if (key == 0) // keypad 0 has no lane: it shows or hides the profiler overlay
+    {
+        profOverlay = !profOverlay;
+        queue_cmd(RC_PROFILER, profOverlay, 0, 0, 0, 0, 0);
+        return;
+    }
     key = key - 1; // convert to 0-indexed key
     // Check if the key pressed is valid
     if (key >= 0 && key < numLanes)
@@ -1526,88 +2099,79 @@ void key_pressed_callback_game(int key)
             play_high_c();
         }
 
-        // Check if there are any notes in the lane
-        if (activeNotesInLane[key] > 0)
+        // Judge the press against the oldest note in the lane still waiting to be hit
+        note_id n = next_note_to_hit(key, time_us);
+        int32_t error = (n != NOTE_NONE) ? (int32_t)(time_us - notePool.hitTime[n]) : 0; // early < 0 < late
+        int grade = (n != NOTE_NONE) ? judge_grade(error) : JUDGE_NONE;
+        if (grade != JUDGE_NONE)
         {
-            // printf ("key pos: %f\n", notes[key][activeNotesInLane[key]-1].y); // Print the position of the key pressed
-            // printf ("Key is low enough %d\n", notes[key][activeNotesInLane[key]-1].y > (SCREEN_HEIGHT - hitHeight));
-            // printf ("Key is high enough %d\n", notes[key][activeNotesInLane[key]-1].y < (SCREEN_HEIGHT - hitHeight + hitWidth)); // Print the position of the key pressed
-            // Check if the note is in the correct position
-            for (int i = 0; i < activeNotesInLane[key]; i++)
+            notePool.flags[n] |= NOTE_JUDGED;
+            if (notePool.flags[n] & NOTE_SUSTAIN)
             {
-                note noteKey = notes[key][i];
-
-                // Check if the note is in the correct position
-                if (check_hit(noteKey))
-                {
-                    notes[key][i].hit = true; // mark the note as hit
-                    numNotesHit++;            // increment the number of notes hit
-                    // play_sound();             // play sound
-                    //  if (key == 0) {
-                    //      play_c();
-                    //  }
-                    //  if (key == 1) {
-                    //      play_cSharp();
-                    //  }
-                    //  if (key == 2) {
-                    //      play_d();
-                    //  }
-                    //  if (key == 3) {
-                    //      play_dSharp();
-                    //  }
-                    //  if (key == 4) {
-                    //      play_e();
-                    //  }
-                    //  if (key == 5) {
-                    //      play_f();
-                    //  }
-                    //  if (key == 6) {
-                    //      play_fSharp();
-                    //  }
-                    //  if (key == 7) {
-                    //      play_g();
-                    //  }
-                    //  if (key == 8) {
-                    //      play_gSharp();
-                    //  }
-                    //  if (key == 9) {
-                    //      play_a();
-                    //  }
-                    //  if (key == 10) {
-                    //      play_aSharp();
-                    //  }
-                    //  if (key == 11) {
-                    //      play_b();
-                    //  }
-                    //  if (key == 12) {
-                    //      play_c();
-                    //  }
-                    combo++;                                                                                       // increment the combo counter
-                    if (abs(notes[key][i].y + notes[key][i].height - (SCREEN_HEIGHT - hitHeight + hitWidth)) < 20) // if the note is hit perfectly
-                    {
-                        // write perfect on the screen
-                        setCursor(SCREEN_WIDTH - 100, 10);
-                        setTextColor2(WHITE, GREEN);
-                        setTextSize(2);
-                        writeString("PERFECT!");
-                    }
-                    else if (abs(notes[key][i].y + notes[key][i].height - (SCREEN_HEIGHT - hitHeight + hitWidth)) < 30) // if the note is hit well
-                    {
-                        // write GOOD on the screen
-                        setCursor(SCREEN_WIDTH - 100, 10);
-                        setTextColor2(WHITE, GREEN);
-                        setTextSize(2);
-                        writeString("GOOD!!!!!");
-                    }
-                    else // if the note is hit poorly
-                    {
-                        // write GOOD on the screen
-                        setCursor(SCREEN_WIDTH - 100, 10);
-                        setTextColor2(WHITE, RED);
-                        setTextSize(2);
-                        writeString("BAD!!!!!!!!");
-                    }
-                }
+                notePool.flags[n] |= NOTE_HIT; // played for as long as the key is held
+                heldSustain[key] = n;
+            }
+            else
+            {
+                erase_note(key, notePool.laneJudge[key]); // a tap is done: n is at the judge cursor
+            }
+            numNotesHit++; // increment the number of notes hit
+            judge_record(grade, error);
+            // play_sound();             // play sound
+            //  if (key == 0) {
+            //      play_c();
+            //  }
+            //  if (key == 1) {
+            //      play_cSharp();
+            //  }
+            //  if (key == 2) {
+            //      play_d();
+            //  }
+            //  if (key == 3) {
+            //      play_dSharp();
+            //  }
+            //  if (key == 4) {
+            //      play_e();
+            //  }
+            //  if (key == 5) {
+            //      play_f();
+            //  }
+            //  if (key == 6) {
+            //      play_fSharp();
+            //  }
+            //  if (key == 7) {
+            //      play_g();
+            //  }
+            //  if (key == 8) {
+            //      play_gSharp();
+            //  }
+            //  if (key == 9) {
+            //      play_a();
+            //  }
+            //  if (key == 10) {
+            //      play_aSharp();
+            //  }
+            //  if (key == 11) {
+            //      play_b();
+            //  }
+            //  if (key == 12) {
+            //      play_c();
+            //  }
+            combo++;                       // increment the combo counter
+            if (grade == JUDGE_PERFECT) // if the note is hit perfectly
+            {
+                // write perfect on the screen
+                draw_banner(BANNER_PERFECT);
+            }
+            else if (grade == JUDGE_GOOD) // if the note is hit well
+            {
+                // write GOOD on the screen
+                draw_banner(BANNER_GOOD);
+            }
+            else // if the note is hit poorly
+            {
+                // write BAD on the screen
+                draw_banner(BANNER_BAD);
             }
         }
     }
@@ -1628,22 +2192,11 @@ void key_released_callback_game(int key)
         draw_piano(key, 0); // draw the piano keys on the screen
         // printf("Key released: %d\n", key); // Print the key released for debugging
 
-        // Check if there are any notes in the lane
-        if (activeNotesInLane[key] > 0)
+        // releasing the key stops the sustain it was playing; update_notes() lets it fall away
+        if (heldSustain[key] != NOTE_NONE)
         {
-            // printf ("key pos: %f\n", notes[key][activeNotesInLane[key]-1].y); // Print the position of the key pressed
-            // printf ("Key is low enough %d\n", notes[key][activeNotesInLane[key]-1].y > (SCREEN_HEIGHT - hitHeight));
-            // printf ("Key is high enough %d\n", notes[key][activeNotesInLane[key]-1].y < (SCREEN_HEIGHT - hitHeight + hitWidth)); // Print the position of the key pressed
-            // Check if the note is in the correct position
-            for (int i = 0; i < activeNotesInLane[key]; i++)
-            {
-                note noteKey = notes[key][i];
-                // Check if the note is in the correct position
-                // if (check_hit(noteKey))
-                // {
-                notes[key][i].hit = false; // mark the note as hit
-                // }
-            }
+            notePool.flags[heldSustain[key]] &= ~NOTE_HIT;
+            heldSustain[key] = NOTE_NONE;
         }
     }
 }
@@ -1653,23 +2206,189 @@ void key_released_callback_game(int key)
 // ================================================================================================================
 
 // ===========================================
-// =============== LED BLINKY ================
+// ============= SERIAL CONSOLE ==============
+// ===========================================
+// Live tuning and telemetry over stdio, see console.h
+
+static void cmd_gravity(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        float speed = strtof(argv[1], NULL);
+        if (menu_state == 1)
+        {
+            printf("gravity: not during a game, the notes on screen were timed for the old speed\n");
+        }
+        else if (speed < 0.25f || speed > 20.0f)
+        {
+            printf("gravity: 0.25 to 20 pixels per frame\n");
+        }
+        else
+        {
+            gravity = float2fix15(speed);
+        }
+    }
+    printf("gravity %.3f pixels per frame\n", fix2float15(gravity));
+}
+
+static void cmd_windows(int argc, char **argv)
+{
+    if (argc == 4 && menu_state == 1)
+    {
+        printf("windows: not during a game, its recording has the old ones\n");
+    }
+    else if (argc == 4)
+    {
+        judge_set_windows_ms(atoi(argv[1]), atoi(argv[2]), atoi(argv[3])); // clamped to JUDGE_WINDOW_MAX_MS
+    }
+    else if (argc != 1)
+    {
+        printf("windows: give all three, in ms\n");
+    }
+    printf("windows perfect %lu, good %lu, bad %lu ms\n", (unsigned long)judgeWindowUs[JUDGE_PERFECT] / 1000,
+           (unsigned long)judgeWindowUs[JUDGE_GOOD] / 1000, (unsigned long)judgeWindowUs[JUDGE_BAD] / 1000);
+}
+
+static void cmd_rate(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        int hz = atoi(argv[1]);
+        if (hz < 2000 || hz > 48000)
+        {
+            printf("rate: 2000 to 48000 Hz\n");
+        }
+        else
+        {
+            audio_set_rate(hz);
+        }
+    }
+    printf("rate %d Hz\n", audioRateHz);
+}
+
+static void cmd_budget(int argc, char **argv)
+{
+    if (argc > 1 && atoi(argv[1]) > 0)
+    {
+        frameBudgetUs = atoi(argv[1]);
+    }
+    printf("budget %d us per tick\n", frameBudgetUs);
+}
+
+static void cmd_prof(int argc, char **argv)
+{
+    prof_dump_csv();
+}
+
+// only reads the counters: they cover the game being played, or the last one, until the next starts
+static void cmd_stats(int argc, char **argv)
+{
+    core_load_print();
+    frame_stats_print();
+    pt_stats_print(0);
+    pt_stats_print(1);
+    coro_exec_print();
+    judge_print_session();
+}
+
+static void cmd_rec(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "on") == 0)
+    {
+        recordGames = true;
+    }
+    else if (argc > 1 && strcmp(argv[1], "off") == 0)
+    {
+        recordGames = false;
+        if (replay_recording())
+        {
+            replay_stop(); // the game being played is not kept either
+        }
+    }
+    else if (argc > 1 && strcmp(argv[1], "dump") == 0)
+    {
+        replay_dump();
+    }
+    else if (argc > 1 && strcmp(argv[1], "play") == 0)
+    {
+        if (menu_state == 0)
+        {
+            replay_game();
+        }
+        else
+        {
+            printf("rec: play from the menu\n");
+        }
+    }
+    printf("rec %s%s%s\n", recordGames ? "on" : "off", replay_recording() ? ", recording" : "",
+           replay_playing() ? ", playing" : "");
+}
+
+static const console_command consoleCommands[] = {
+    {"gravity", "[PIXELS]: note speed per frame, set from the menu", cmd_gravity},
+    {"windows", "[PERFECT GOOD BAD]: judging windows in ms, set from the menu", cmd_windows},
+    {"rate", "[HZ]: DAC sample rate", cmd_rate},
+    {"budget", "[US]: game tick time counted as an overrun", cmd_budget},
+    {"prof", ": frame profile as CSV", cmd_prof},
+    {"stats", ": core load, frames, threads, coroutines and judging", cmd_stats},
+    {"rec", "[on|off|dump|play]: record games, print or play the last one", cmd_rec},
+};
+
+// the thread comes back this often even without an interrupt
+#define CONSOLE_POLL_US 100000
+
+/**
+ * @brief stdio interrupt hook: wakes the console thread
+ */
+static void console_rx(void)
+{
+    pt_event_signal(EVENT_CONSOLE);
+}
+
+static PT_THREAD(protothread_console(struct pt *pt))
+{
+    // Initialize protothread and parameters
+    PT_BEGIN(pt);
+
+    console_init(consoleCommands, sizeof(consoleCommands) / sizeof(consoleCommands[0]), console_rx);
+
+    while (1)
+    {
+        // runs every complete line; never waits for one
+        console_poll();
+        PT_YIELD_EVENT_usec(EVENT_CONSOLE, CONSOLE_POLL_US);
+    }
+    // End the protothread
+    PT_END(pt);
+}
+
+// ===========================================
+// ============ COROUTINE TASKS ==============
 // ===========================================
-static PT_THREAD(protothread_blinky(struct pt *pt))
+/**
+ * @brief Coroutine event hook: wakes protothread_coro
+ */
+static void coro_signalled(void)
 {
-    // used to tell if the program is running
+    pt_event_signal(EVENT_CORO);
+}
 
+// runs the C++ coroutine tasks (coro_exec.hpp) among the protothreads
+static PT_THREAD(protothread_coro(struct pt *pt))
+{
     // Initialize protothread and parameters
     PT_BEGIN(pt);
-    static int i = 0;
+    static uint64_t wake;
+
+    coro_exec_init(coro_signalled);
+    // blink the LED every 50ms, to tell the program is running
+    coro_blink_start(LED, 50000);
 
-    // Main loop to blink the LED
     while (1)
     {
-        // Blink the LED every 50ms
-        gpio_put(LED, i % 2);
-        i++;
-        PT_YIELD_usec(50000);
+        // every task that is due, then asleep until the next one or an event
+        wake = coro_exec_run();
+        PT_YIELD_EVENT_UNTIL_usec(EVENT_CORO, wake);
     }
     // End the protothread
     PT_END(pt);
@@ -1678,6 +2397,8 @@ static PT_THREAD(protothread_blinky(struct pt *pt))
 ///////////////////////////////////////////////////////////////
 // MAIN FUNCTION
 ///////////////////////////////////////////////////////////////
+// host tools (host/) include this file and provide their own main
+#ifndef HOST_SIM
 int main()
 {
 
@@ -1754,22 +2475,15 @@ int main()
     // initialize VGA
     initVGA();
 
+    // the game queues drawing from here on; RENDER_CORE runs it
+    render_queue_init(render_execute, RENDER_CORE);
+    core_load_reset();
+
     // Map LED to GPIO port, make it low
     gpio_init(LED);
     gpio_set_dir(LED, GPIO_OUT);
     gpio_put(LED, 0);
 
-    // Initialize the keypad GPIO's
-    gpio_init_mask((0x7F << BASE_KEYPAD_PIN));
-    // Set row-pins to output
-    gpio_set_dir_out_masked((0xF << BASE_KEYPAD_PIN));
-    // Set all output pins to low
-    gpio_put_masked((0xF << BASE_KEYPAD_PIN), (0x0 << BASE_KEYPAD_PIN));
-    // Turn on pulldown resistors for column pins (on by default)
-    gpio_pull_down((BASE_KEYPAD_PIN + 4));
-    gpio_pull_down((BASE_KEYPAD_PIN + 5));
-    gpio_pull_down((BASE_KEYPAD_PIN + 6));
-
     // while(1){
     // play_c();
     // sleep_ms(500);
@@ -1834,12 +2548,25 @@ int main()
     //     sleep_ms(500);
     //     sleep_ms(1500);
     // }
+    // Both cores call threads by wake-up time and sleep in between
+    pt_sched_method = SCHED_DEADLINE;
+
+    // Start the renderer on core 1
+#if RENDER_CORE == 1
+    multicore_launch_core1(core1_main);
+#endif
+
     // Add core 0 threads
     pt_add_thread(protothread_animation_loop);
-    pt_add_thread(protothread_blinky);
+    pt_add_thread(protothread_coro);
     pt_add_thread(protothread_keypad_scan);
     pt_add_thread(protothread_piano_scan);
-    pt_add_thread(protothread_twinkle_notes);
+    pt_add_thread(protothread_chart_notes);
+    pt_add_thread(protothread_console);
+#if RENDER_CORE == 0
+    pt_add_thread(protothread_render);
+#endif
     // Start scheduling core 0 threads
     pt_schedule_start;
-}
\ No newline at end of file
+}
+#endif // HOST_SIM
@@ -0,0 +1,103 @@
+/**
+ * Binary note charts -- see chart.h for the format
+ */
+#include "chart.h"
+
+static uint32_t read_varint(const unsigned char **pos)
+{
+    uint32_t value = 0;
+    int shift = 0;
+    unsigned char b;
+    do
+    {
+        b = *(*pos)++;
+        value |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while ((b & 0x80) && shift < 32);
+    return value;
+}
+
+// tick -> microseconds at the current tempo
+static uint32_t tick_to_us(const chart_cursor *cursor, uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * cursor->usPerQuarter) / cursor->ticksPerQuarter);
+}
+
+// Decodes events into cursor->next, applying any tempo changes on the way
+static void decode_next(chart_cursor *cursor)
+{
+    chart_event *ev = &cursor->next;
+    while (1)
+    {
+        uint32_t tick = ev->tick + read_varint(&cursor->pos);
+        unsigned char b = *cursor->pos++;
+
+        ev->kind = b & CHART_KIND_MASK;
+        ev->lane = b & CHART_LANE_MASK;
+        ev->tick = tick;
+        ev->time_us = cursor->tempoTimeUs + tick_to_us(cursor, tick - cursor->tempoTick);
+        ev->duration_us = 0;
+
+        if (ev->kind == CHART_TEMPO)
+        {
+            cursor->tempoTimeUs = ev->time_us;
+            cursor->tempoTick = tick;
+            cursor->usPerQuarter = read_varint(&cursor->pos);
+            continue; // tempo changes are not handed to the game
+        }
+        if (ev->kind == CHART_SUSTAIN)
+        {
+            ev->duration_us = tick_to_us(cursor, read_varint(&cursor->pos));
+        }
+        else if (ev->kind != CHART_TAP && ev->kind != CHART_SAMPLE)
+        {
+            ev->kind = CHART_END; // END, or a kind this build does not know
+            cursor->done = true;
+        }
+        return;
+    }
+}
+
+/**
+ * @brief Points a cursor at the first event of a chart
+ * @return false if the data is not a chart this code can read
+ */
+bool chart_open(chart_cursor *cursor, const unsigned char *chart)
+{
+    if (chart[0] != 'R' || chart[1] != 'B' || chart[2] != 'C' || chart[3] != 'H' || chart[4] != CHART_VERSION || (chart[6] | chart[7]) == 0)
+    {
+        cursor->done = true;
+        cursor->next.kind = CHART_END;
+        cursor->next.tick = 0;
+        cursor->next.time_us = 0;
+        return false;
+    }
+    cursor->ticksPerQuarter = chart[6] | (chart[7] << 8);
+    cursor->usPerQuarter = chart[8] | (chart[9] << 8) | ((uint32_t)chart[10] << 16) | ((uint32_t)chart[11] << 24);
+    cursor->tempoTick = 0;
+    cursor->tempoTimeUs = 0;
+    cursor->pos = chart + CHART_HEADER_BYTES;
+    cursor->done = false;
+    cursor->next.tick = 0;
+    decode_next(cursor);
+    return true;
+}
+
+/**
+ * @brief The event at the cursor (a CHART_END event once the song is over)
+ */
+const chart_event *chart_peek(const chart_cursor *cursor)
+{
+    return &cursor->next;
+}
+
+/**
+ * @brief Moves past the event returned by chart_peek; stays put on CHART_END
+ */
+void chart_advance(chart_cursor *cursor)
+{
+    if (!cursor->done)
+    {
+        decode_next(cursor);
+    }
+}
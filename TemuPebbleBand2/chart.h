@@ -0,0 +1,65 @@
+/**
+ * Binary note charts, read in place from flash through a cursor.
+ *
+ * A chart is a header followed by a stream of events. Every event
+ * starts with the ticks since the previous event as an unsigned LEB128
+ * varint, then a kind/lane byte (kind in the top three bits, lane or
+ * sample id in the bottom five), then a kind-specific payload:
+ *
+ *   header   "RBCH", version (1), 0, ticks per quarter (u16 LE),
+ *            starting microseconds per quarter (u32 LE)
+ *   TAP      no payload
+ *   SUSTAIN  duration in ticks (varint)
+ *   TEMPO    new microseconds per quarter (varint), lane bits unused
+ *   SAMPLE   no payload -- play one-shot sample <lane>
+ *   END      no payload -- the song is over at this tick
+ *
+ * Event times are when a note should be hit, not when it spawns. The
+ * cursor converts ticks to microseconds through the tempo map as it
+ * goes, so reading a chart needs no RAM beyond the cursor itself.
+ *
+ * chart_generation/midi_to_chart.py builds charts from MIDI files.
+ */
+#ifndef CHART_H
+#define CHART_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CHART_VERSION 1
+#define CHART_HEADER_BYTES 12
+
+// event kinds (top three bits of the kind/lane byte)
+#define CHART_TAP 0x00
+#define CHART_SUSTAIN 0x20
+#define CHART_TEMPO 0x40
+#define CHART_SAMPLE 0x60
+#define CHART_END 0xE0
+#define CHART_KIND_MASK 0xE0
+#define CHART_LANE_MASK 0x1F
+
+typedef struct chart_event
+{
+    unsigned char kind;   // CHART_TAP, CHART_SUSTAIN, CHART_SAMPLE or CHART_END
+    unsigned char lane;   // lane, or sample id for CHART_SAMPLE
+    uint32_t tick;        // ticks from the start of the song
+    uint32_t time_us;     // microseconds from the start of the song
+    uint32_t duration_us; // sustain length (0 for everything else)
+} chart_event;
+
+typedef struct chart_cursor
+{
+    const unsigned char *pos;     // next unread byte
+    unsigned short ticksPerQuarter;
+    uint32_t usPerQuarter;        // current tempo
+    uint32_t tempoTick;           // tick and time of the last tempo change
+    uint32_t tempoTimeUs;
+    bool done;                    // next holds CHART_END, nothing after it
+    chart_event next;             // decoded event at the cursor
+} chart_cursor;
+
+bool chart_open(chart_cursor *cursor, const unsigned char *chart);
+const chart_event *chart_peek(const chart_cursor *cursor);
+void chart_advance(chart_cursor *cursor);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef CHART_FAIRY_FOUNTAIN_H
+#define CHART_FAIRY_FOUNTAIN_H
+
+// Great Fairy Fountain -- one note per quarter at 75 bpm, sample 0 is the high D.
+// Binary chart, see chart.h for the format.
+const unsigned char chart_great_fairy_fountain[107] = {
+    0x52, 0x42, 0x43, 0x48, 0x01, 0x00, 0xe0, 0x01, 0x00, 0x35, 0x0c, 0x00, 0x00, 0x0b, 0xe0, 0x03,
+    0x09, 0xe0, 0x03, 0x08, 0xe0, 0x03, 0x09, 0xe0, 0x03, 0x09, 0xe0, 0x03, 0x07, 0xe0, 0x03, 0x06,
+    0xe0, 0x03, 0x07, 0xe0, 0x03, 0x07, 0xe0, 0x03, 0x06, 0xe0, 0x03, 0x05, 0xe0, 0x03, 0x06, 0xe0,
+    0x03, 0x06, 0xe0, 0x03, 0x04, 0xe0, 0x03, 0x03, 0xe0, 0x03, 0x04, 0xe0, 0x03, 0x0b, 0xe0, 0x03,
+    0x09, 0xe0, 0x03, 0x08, 0xe0, 0x03, 0x0c, 0xe0, 0x03, 0x0b, 0xe0, 0x03, 0x0a, 0xe0, 0x03, 0x0b,
+    0xe0, 0x03, 0x60, 0xe0, 0x03, 0x0c, 0xe0, 0x03, 0x0b, 0xe0, 0x03, 0x0c, 0xe0, 0x03, 0x0b, 0xe0,
+    0x03, 0x09, 0xe0, 0x03, 0x07, 0xe0, 0x03, 0x06, 0x80, 0x0f, 0xe0
+};
+
+#endif
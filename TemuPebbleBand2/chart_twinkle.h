@@ -0,0 +1,19 @@
+#ifndef CHART_TWINKLE_H
+#define CHART_TWINKLE_H
+
+// Twinkle Twinkle Little Star -- one note per quarter at 75 bpm, with six sustains.
+// Binary chart, see chart.h for the format.
+const unsigned char chart_twinkle_twinkle[152] = {
+    0x52, 0x42, 0x43, 0x48, 0x01, 0x00, 0xe0, 0x01, 0x00, 0x35, 0x0c, 0x00, 0x00, 0x20, 0xa0, 0x02,
+    0xe0, 0x03, 0x00, 0xe0, 0x03, 0x07, 0xe0, 0x03, 0x07, 0xe0, 0x03, 0x09, 0xe0, 0x03, 0x09, 0xe0,
+    0x03, 0x27, 0xa0, 0x02, 0xe0, 0x03, 0x05, 0xe0, 0x03, 0x05, 0xe0, 0x03, 0x04, 0xe0, 0x03, 0x04,
+    0xe0, 0x03, 0x02, 0xe0, 0x03, 0x02, 0xe0, 0x03, 0x00, 0xe0, 0x03, 0x07, 0xe0, 0x03, 0x07, 0xe0,
+    0x03, 0x05, 0xe0, 0x03, 0x05, 0xe0, 0x03, 0x04, 0xe0, 0x03, 0x04, 0xe0, 0x03, 0x22, 0xa0, 0x02,
+    0xe0, 0x03, 0x07, 0xe0, 0x03, 0x07, 0xe0, 0x03, 0x05, 0xe0, 0x03, 0x05, 0xe0, 0x03, 0x04, 0xe0,
+    0x03, 0x04, 0xe0, 0x03, 0x22, 0xa0, 0x02, 0xe0, 0x03, 0x00, 0xe0, 0x03, 0x00, 0xe0, 0x03, 0x07,
+    0xe0, 0x03, 0x07, 0xe0, 0x03, 0x09, 0xe0, 0x03, 0x09, 0xe0, 0x03, 0x27, 0xa0, 0x02, 0xe0, 0x03,
+    0x05, 0xe0, 0x03, 0x05, 0xe0, 0x03, 0x04, 0xe0, 0x03, 0x04, 0xe0, 0x03, 0x02, 0xe0, 0x03, 0x02,
+    0xe0, 0x03, 0x20, 0xa0, 0x02, 0x80, 0x0f, 0xe0
+};
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * Serial command console -- see console.h
+ */
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "console.h"
+
+static const console_command *table;
+static int tableSize;
+static void (*onRx)(void);
+
+static char line[CONSOLE_LINE];
+static int lineLength;
+static int lastChar; // to take a "\r\n" as one Enter
+
+// stdio's chars-available interrupt
+static void rx_ready(void *param)
+{
+    (void)param;
+    if (onRx)
+    {
+        onRx();
+    }
+}
+
+/**
+ * @brief Starts taking commands from stdio
+ * @param on_rx called from an interrupt when characters arrive, or NULL to rely on polling
+ */
+void console_init(const console_command *commands, int count, void (*on_rx)(void))
+{
+    table = commands;
+    tableSize = count;
+    onRx = on_rx;
+    lineLength = 0;
+    stdio_set_chars_available_callback(rx_ready, NULL);
+    printf("> ");
+}
+
+static void help(void)
+{
+    printf("help\n");
+    for (int i = 0; i < tableSize; i++)
+    {
+        printf("%s%s%s\n", table[i].name, table[i].usage[0] == ':' ? "" : " ", table[i].usage);
+    }
+}
+
+/**
+ * @brief Splits text into words and runs the command named by the first
+ * The text is cut up in place.
+ */
+void console_exec(char *text)
+{
+    char *argv[CONSOLE_ARGS];
+    int argc = 0;
+    for (char *word = strtok(text, " \t"); word && argc < CONSOLE_ARGS; word = strtok(NULL, " \t"))
+    {
+        argv[argc++] = word;
+    }
+    if (argc == 0)
+    {
+        return;
+    }
+    if (strcmp(argv[0], "help") == 0)
+    {
+        help();
+        return;
+    }
+    for (int i = 0; i < tableSize; i++)
+    {
+        if (strcmp(argv[0], table[i].name) == 0)
+        {
+            table[i].run(argc, argv);
+            return;
+        }
+    }
+    printf("%s: no such command, try help\n", argv[0]);
+}
+
+/**
+ * @brief Takes every character that has arrived, running each line completed
+ */
+void console_poll(void)
+{
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT)
+    {
+        if (c == '\n' && lastChar == '\r')
+        {
+            lastChar = c;
+            continue;
+        }
+        lastChar = c;
+        if (c == '\r' || c == '\n')
+        {
+            printf("\n");
+            line[lineLength] = 0;
+            lineLength = 0;
+            console_exec(line);
+            printf("> ");
+        }
+        else if (c == '\b' || c == 0x7f)
+        {
+            if (lineLength > 0)
+            {
+                lineLength--;
+                printf("\b \b");
+            }
+        }
+        else if (c >= ' ' && lineLength < CONSOLE_LINE - 1)
+        {
+            line[lineLength++] = c;
+            putchar(c);
+        }
+    }
+}
@@ -0,0 +1,29 @@
+/**
+ * Serial command console.
+ *
+ * Reads stdio (the UART, or USB if that is what stdio is on) without ever
+ * waiting: stdio's chars-available interrupt calls the on_rx hook given
+ * to console_init(), and the thread it wakes calls console_poll(), which
+ * takes whatever has arrived. Characters are echoed, backspace edits the
+ * line, and Enter splits it into words and runs the command named by the
+ * first one from the table given to console_init(). "help" lists the
+ * table. Commands print their replies with printf.
+ */
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#define CONSOLE_LINE 64 // characters per command line
+#define CONSOLE_ARGS 8  // words per command line, the command's name included
+
+typedef struct console_command
+{
+    const char *name;
+    const char *usage;                  // arguments and what the command does, for help
+    void (*run)(int argc, char **argv); // argv[0] is the name
+} console_command;
+
+void console_init(const console_command *commands, int count, void (*on_rx)(void));
+void console_poll(void);
+void console_exec(char *text);
+
+#endif
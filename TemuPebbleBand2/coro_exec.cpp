@@ -0,0 +1,160 @@
+/**
+ * Coroutine executor and frame pool -- see coro_exec.hpp and coro_exec.h
+ */
+#include <stdio.h>
+#include "hardware/sync.h"
+#include "coro_exec.hpp"
+
+namespace coro
+{
+
+// === frame pool ====================================================
+
+alignas(8) static unsigned char frames[CORO_FRAME_SLOTS][CORO_FRAME_SIZE];
+static uint32_t framesUsed;          // bit n: frames[n] is taken
+static unsigned int framesFailed;    // allocations refused
+static std::size_t largestFrame;     // biggest frame asked for
+
+static_assert(CORO_FRAME_SLOTS <= 32, "framesUsed has one bit per slot");
+
+/**
+ * @brief Takes a free frame slot, or returns nullptr if none is left or size is too big
+ */
+void *frame_alloc(std::size_t size) noexcept
+{
+    if (size > largestFrame)
+    {
+        largestFrame = size;
+    }
+    uint32_t avail = ~framesUsed & ((CORO_FRAME_SLOTS == 32) ? 0xFFFFFFFFu : ((1u << CORO_FRAME_SLOTS) - 1));
+    if (size > CORO_FRAME_SIZE || !avail)
+    {
+        framesFailed++;
+        return nullptr;
+    }
+    int n = __builtin_ctz(avail);
+    framesUsed |= 1u << n;
+    return frames[n];
+}
+
+void frame_free(void *frame) noexcept
+{
+    int n = ((unsigned char *)frame - &frames[0][0]) / CORO_FRAME_SIZE;
+    framesUsed &= ~(1u << n);
+}
+
+// === executor ======================================================
+
+static slot slots[CORO_MAX_TASKS];
+static slot *current;
+static void (*onSignal)(void);
+
+slot *current_slot(void) noexcept
+{
+    return current;
+}
+
+/**
+ * @brief Starts a task on the next coro_exec_run()
+ * @return false if the task is empty or every task slot is taken; the task is dropped
+ */
+bool spawn(task &&t) noexcept
+{
+    if (!t)
+    {
+        return false;
+    }
+    for (slot &s : slots)
+    {
+        if (!s.root)
+        {
+            s.root = t.release();
+            s.resume = s.root;
+            s.wake = 0;
+            s.ev = nullptr;
+            s.finished = false;
+            return true;
+        }
+    }
+    return false; // t's destructor frees the frame
+}
+
+void event::signal(void) noexcept
+{
+    flag = true;
+    __sev();
+    if (onSignal)
+    {
+        onSignal();
+    }
+}
+
+} // namespace coro
+
+using namespace coro;
+
+/**
+ * @brief Sets the hook event::signal() calls, so the executor's thread can be woken
+ */
+void coro_exec_init(void (*on_signal)(void))
+{
+    onSignal = on_signal;
+}
+
+/**
+ * @brief Resumes every task whose time has come or whose event is set, once each
+ * The clock is read once, so a task that falls due during the pass waits for the next.
+ * @return the earliest time a waiting task is due, 0 if one is due already,
+ *         CORO_NO_WAKE if all of them wait on events (or there are none)
+ */
+uint64_t coro_exec_run(void)
+{
+    uint64_t now = time_us_64();
+    for (slot &s : slots)
+    {
+        if (s.root && ((s.ev && s.ev->signalled()) || s.wake <= now))
+        {
+            current = &s;
+            s.resume.resume();
+            current = nullptr;
+            if (s.finished)
+            {
+                s.root.destroy();
+                s.root = nullptr;
+            }
+        }
+    }
+    // signals from the tasks just run, or from interrupts meanwhile, count too
+    uint64_t next = CORO_NO_WAKE;
+    for (slot &s : slots)
+    {
+        if (!s.root)
+        {
+            continue;
+        }
+        if (s.ev && s.ev->signalled())
+        {
+            return 0;
+        }
+        if (s.wake < next)
+        {
+            next = s.wake;
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Prints the tasks running and the frame pool's use
+ */
+void coro_exec_print(void)
+{
+    int tasks = 0;
+    for (slot &s : slots)
+    {
+        tasks += (s.root != nullptr);
+    }
+    printf("coro: %d/%d tasks, %d/%d frames of %d bytes, largest asked %u, refused %u\n", tasks, CORO_MAX_TASKS,
+           __builtin_popcount(framesUsed), CORO_FRAME_SLOTS, CORO_FRAME_SIZE, (unsigned int)largestFrame,
+           framesFailed);
+}
@@ -0,0 +1,33 @@
+/**
+ * C side of the coroutine executor (coro_exec.hpp).
+ *
+ * The executor runs C++20 coroutine tasks on one core, next to the
+ * protothreads: a protothread calls coro_exec_run(), which resumes every
+ * task that is due, and then sleeps until the time it returns or until
+ * a coroutine event is signalled, which calls the on_signal hook given
+ * to coro_exec_init() (from an interrupt, if that is where the event
+ * was signalled).
+ */
+#ifndef CORO_EXEC_H
+#define CORO_EXEC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CORO_NO_WAKE UINT64_MAX // coro_exec_run(): no task is waiting on a time
+
+void coro_exec_init(void (*on_signal)(void));
+uint64_t coro_exec_run(void);
+void coro_exec_print(void);
+
+// game tasks, coro_tasks.cpp
+void coro_blink_start(unsigned int pin, uint32_t period_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
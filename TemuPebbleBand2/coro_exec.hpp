@@ -0,0 +1,207 @@
+/**
+ * Stackless C++20 coroutine tasks for the RP2040, next to the protothreads.
+ *
+ * A coroutine keeps its locals in its frame across suspensions, so unlike
+ * a protothread it needs no static locals, can loop and branch freely
+ * around its waits, and can co_await another task as a function call:
+ *
+ *   coro::task blink(uint pin)
+ *   {
+ *       for (int i = 0;; i++)
+ *       {
+ *           gpio_put(pin, i & 1);
+ *           co_await coro::sleep_for(50000);
+ *       }
+ *   }
+ *   ...
+ *   coro::spawn(blink(LED));
+ *
+ * Frames come from a fixed pool of CORO_FRAME_SLOTS slots of
+ * CORO_FRAME_SIZE bytes and never from the heap. A task whose frame does
+ * not fit, or that finds the pool full, is an empty task: spawn() refuses
+ * it and co_await on it returns at once; coro_exec_print() counts these.
+ *
+ * Awaitables:
+ *   sleep_until(t)   resume once time_us_64() >= t
+ *   sleep_for(us)    resume us microseconds from now
+ *   yield()          resume on the next coro_exec_run()
+ *   ev.wait()        resume once event ev is signalled (see event below)
+ *   a task           run it to its end, then resume
+ *
+ * All tasks run on the core that calls coro_exec_run(); spawn() and the
+ * awaitables may only be used there. event::signal() may be called from
+ * anywhere, interrupts included.
+ */
+#ifndef CORO_EXEC_HPP
+#define CORO_EXEC_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include "pico/stdlib.h"
+#include "coro_exec.h"
+
+#define CORO_MAX_TASKS 8     // tasks spawned at once
+#define CORO_FRAME_SLOTS 16  // frames alive at once, nested tasks included
+#define CORO_FRAME_SIZE 256  // bytes per frame
+
+namespace coro
+{
+
+void *frame_alloc(std::size_t size) noexcept;
+void frame_free(void *frame) noexcept;
+
+class event;
+
+// the task being resumed: where an awaitable leaves what it waits for
+struct slot
+{
+    std::coroutine_handle<> root;   // the spawned task, destroyed when it ends
+    std::coroutine_handle<> resume; // innermost coroutine to resume
+    uint64_t wake;                  // resume once time_us_64() reaches this
+    event *ev;                      // or once this is signalled
+    bool finished;
+};
+
+slot *current_slot(void) noexcept;
+
+/**
+ * @brief A coroutine that starts suspended and runs when spawned or awaited
+ */
+class task
+{
+public:
+    struct promise_type;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    struct final_awaiter
+    {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(handle_type h) noexcept
+        {
+            std::coroutine_handle<> parent = h.promise().continuation;
+            if (parent)
+            {
+                return parent; // back to the task that awaited this one
+            }
+            current_slot()->finished = true; // a spawned task: the executor frees it
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    struct promise_type
+    {
+        std::coroutine_handle<> continuation;
+
+        task get_return_object() noexcept { return task(handle_type::from_promise(*this)); }
+        static task get_return_object_on_allocation_failure() noexcept { return task(); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        final_awaiter final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {} // built without exceptions
+
+        static void *operator new(std::size_t size) noexcept { return frame_alloc(size); }
+        static void operator delete(void *frame) noexcept { frame_free(frame); }
+    };
+
+    task() noexcept : handle() {}
+    explicit task(handle_type h) noexcept : handle(h) {}
+    task(task &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+    ~task()
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    explicit operator bool() const noexcept { return (bool)handle; }
+
+    // co_await: runs the task to its end inside the awaiting one
+    bool await_ready() const noexcept { return !handle; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    void await_resume() const noexcept {}
+
+    // hands the frame to the executor
+    handle_type release() noexcept
+    {
+        handle_type h = handle;
+        handle = nullptr;
+        return h;
+    }
+
+private:
+    handle_type handle;
+};
+
+bool spawn(task &&t) noexcept;
+
+struct sleep_until
+{
+    uint64_t wake;
+
+    explicit sleep_until(uint64_t t) noexcept : wake(t) {}
+    bool await_ready() const noexcept { return time_us_64() >= wake; }
+    void await_suspend(std::coroutine_handle<> h) const noexcept
+    {
+        slot *s = current_slot();
+        s->resume = h;
+        s->wake = wake;
+        s->ev = nullptr;
+    }
+    void await_resume() const noexcept {}
+};
+
+struct sleep_for : sleep_until
+{
+    explicit sleep_for(uint32_t us) noexcept : sleep_until(time_us_64() + us) {}
+};
+
+struct yield : sleep_until
+{
+    yield() noexcept : sleep_until(0) {}
+    bool await_ready() const noexcept { return false; }
+};
+
+/**
+ * @brief A flag one task waits on and anything may set
+ * signal() sets it and calls the executor's on_signal hook; wait()
+ * resumes once it is set and clears it. Signals before the wait are
+ * kept, several of them count as one.
+ */
+class event
+{
+public:
+    struct awaiter
+    {
+        event &ev;
+
+        bool await_ready() const noexcept { return ev.flag; }
+        void await_suspend(std::coroutine_handle<> h) const noexcept
+        {
+            slot *s = current_slot();
+            s->resume = h;
+            s->wake = CORO_NO_WAKE;
+            s->ev = &ev;
+        }
+        void await_resume() const noexcept { ev.flag = false; }
+    };
+
+    void signal(void) noexcept;
+    bool signalled(void) const noexcept { return flag; }
+    awaiter wait(void) noexcept { return awaiter{*this}; }
+
+private:
+    volatile bool flag = false;
+};
+
+} // namespace coro
+
+#endif
@@ -0,0 +1,22 @@
+/**
+ * The game's coroutine tasks -- see coro_exec.h
+ */
+#include "coro_exec.hpp"
+
+// toggles pin every period_us, to show the program is running
+static coro::task blink(uint pin, uint32_t period_us)
+{
+    for (bool on = false;; on = !on)
+    {
+        gpio_put(pin, on);
+        co_await coro::sleep_for(period_us);
+    }
+}
+
+/**
+ * @brief Starts the LED blink as a coroutine task
+ */
+void coro_blink_start(unsigned int pin, uint32_t period_us)
+{
+    coro::spawn(blink(pin, period_us));
+}
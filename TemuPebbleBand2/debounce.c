@@ -0,0 +1,94 @@
+/**
+ * Per-key debouncing for the input scanners -- see debounce.h
+ */
+#include <stdio.h>
+#include <string.h>
+#include "debounce.h"
+
+/**
+ * @brief Clears d for keys keys, all released
+ */
+void debounce_init(debouncer *d, int keys, uint32_t settle_us, int mode)
+{
+    memset(d, 0, sizeof(*d));
+    d->keys = (keys > DEBOUNCE_MAX_KEYS) ? DEBOUNCE_MAX_KEYS : keys;
+    d->settleUs = settle_us;
+    d->mode = mode;
+}
+
+// Flips key k's debounced state and appends the edge
+static int emit(debouncer *d, int k, uint32_t t, key_edge *edges, int n)
+{
+    d->state ^= 1u << k;
+    edges[n].key = k;
+    edges[n].down = (d->state >> k) & 1;
+    edges[n].time_us = t;
+    return n + 1;
+}
+
+/**
+ * @brief Feeds the raw bitmap sampled at time t
+ * Also call it with an unchanged bitmap and a later time to let settling keys finish.
+ * edges needs room for d->keys more entries after the first n.
+ * @return n plus the number of edges appended
+ */
+int debounce_update(debouncer *d, uint16_t raw, uint32_t t, key_edge *edges, int n)
+{
+    uint16_t changed = raw ^ d->raw;
+    if (!changed && !d->settling)
+    {
+        return n;
+    }
+    d->raw = raw;
+
+    for (int k = 0; k < d->keys; k++)
+    {
+        uint16_t bit = 1u << k;
+        if (d->settling & bit)
+        {
+            if (changed & bit)
+            {
+                d->bounces[k]++;
+                d->lastChange[k] = t;
+            }
+            else if ((uint32_t)(t - d->lastChange[k]) >= d->settleUs)
+            {
+                // quiet long enough: whatever the input is now is the key's state
+                d->settling &= ~bit;
+                if ((raw ^ d->state) & bit)
+                {
+                    n = emit(d, k, (d->mode == DEBOUNCE_EAGER) ? d->lastChange[k] : d->since[k], edges, n);
+                }
+                else if (d->mode == DEBOUNCE_SETTLED)
+                {
+                    d->bounces[k]++; // a spike that came back before it settled
+                }
+            }
+        }
+        else if (changed & bit)
+        {
+            d->settling |= bit;
+            d->since[k] = t;
+            d->lastChange[k] = t;
+            if (d->mode == DEBOUNCE_EAGER)
+            {
+                n = emit(d, k, t, edges, n);
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Prints the settle time and the bounce count of every key
+ */
+void debounce_print(const debouncer *d, const char *name)
+{
+    printf("%s: %s, settle %lu us, bounces", name, (d->mode == DEBOUNCE_EAGER) ? "eager" : "settled",
+           (unsigned long)d->settleUs);
+    for (int k = 0; k < d->keys; k++)
+    {
+        printf(" %u", d->bounces[k]);
+    }
+    printf("\n");
+}
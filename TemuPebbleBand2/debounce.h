@@ -0,0 +1,46 @@
+/**
+ * Per-key debouncing for the input scanners.
+ *
+ * A debouncer is fed raw key bitmaps with the time they were sampled,
+ * as often as the scanner likes; samples that change nothing and keys
+ * that are not settling cost one compare. A key that changes is
+ * settling until its raw input has been quiet for settleUs, and every
+ * further change while it settles is counted as a bounce.
+ *
+ * DEBOUNCE_EAGER reports the first change at once and ignores the
+ * bounce after it (lowest latency, but a single noise spike is a
+ * press). DEBOUNCE_SETTLED reports a change only once it has held for
+ * settleUs, so spikes shorter than that are dropped; its edges still
+ * carry the time of the first change, so only the callback is later,
+ * not the timing a press is judged on.
+ */
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+#include "key_edge.h"
+
+#define DEBOUNCE_MAX_KEYS 16
+
+// modes
+#define DEBOUNCE_EAGER 0
+#define DEBOUNCE_SETTLED 1
+
+typedef struct debouncer
+{
+    uint32_t settleUs;                         // quiet time that ends settling
+    uint8_t mode;                              // DEBOUNCE_EAGER or DEBOUNCE_SETTLED
+    uint8_t keys;                              // keys in use, from bit 0
+    uint16_t state;                            // debounced bitmap, bit k = key k held
+    uint16_t raw;                              // last raw bitmap
+    uint16_t settling;                         // keys waiting for their input to go quiet
+    uint32_t since[DEBOUNCE_MAX_KEYS];         // first change of the current settle
+    uint32_t lastChange[DEBOUNCE_MAX_KEYS];    // latest raw change
+    unsigned int bounces[DEBOUNCE_MAX_KEYS];   // changes seen while settling
+} debouncer;
+
+void debounce_init(debouncer *d, int keys, uint32_t settle_us, int mode);
+int debounce_update(debouncer *d, uint16_t raw, uint32_t t, key_edge *edges, int n);
+void debounce_print(const debouncer *d, const char *name);
+
+#endif
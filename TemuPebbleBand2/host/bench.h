@@ -0,0 +1,38 @@
+/**
+ * Tiny timing harness shared by the host benchmarks.
+ *
+ * BENCH_RUN(name, units, iters, body) runs body iters times, prints the
+ * time per iteration and the throughput in units per second, and
+ * returns the elapsed nanoseconds so callers can compute speedups.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts ;
+    clock_gettime(CLOCK_MONOTONIC, &ts) ;
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec ;
+}
+
+static inline void bench_report(const char *name, const char *units, double per_iter,
+                                long iters, uint64_t ns) {
+    double sec = ns / 1e9 ;
+    printf("%-36s %10.1f ns/iter  %12.0f %s/s\n",
+           name, (double)ns / iters, per_iter * iters / sec, units) ;
+}
+
+// Keeps the compiler from discarding benchmark results
+static volatile uint32_t bench_sink ;
+
+#define BENCH_RUN(name, units, per_iter, iters, body) ({ \
+    uint64_t _t0 = bench_now_ns() ; \
+    for (long _i = 0 ; _i < (iters) ; _i++) { body ; } \
+    uint64_t _ns = bench_now_ns() - _t0 ; \
+    bench_report((name), (units), (per_iter), (iters), _ns) ; \
+    _ns ; })
+
+#endif
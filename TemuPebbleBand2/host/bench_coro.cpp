@@ -0,0 +1,100 @@
+/**
+ * Host benchmark of a context switch: a protothread's PT_YIELD and resume
+ * against a C++20 coroutine's suspend and resume (coro_exec.hpp), both
+ * called directly and through a pass over four threads or tasks, plus
+ * what starting a task and awaiting a nested one cost.
+ *
+ * Both kinds of thread save almost nothing when they switch: a
+ * protothread its resume label, a coroutine its resume point and the
+ * locals already in its frame. The executor's pass also reads the clock
+ * and checks every task slot's wake time and event, which the bare
+ * protothread loop here does not; the pt_cornell schedulers do the same
+ * kind of work per thread.
+ */
+#define HOST_SIM
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pt_cornell_rp2040_v1_3.h"
+#include "coro_exec.hpp"
+#include "bench.h"
+
+#define ITERS 20000000L
+#define PASSES 5000000L
+
+static bool stop ;
+
+// === protothreads ==================================================
+
+static PT_THREAD (pt_counter(struct pt *pt)) {
+    PT_BEGIN(pt) ;
+    while (1) {
+        bench_sink = bench_sink + 1 ;
+        PT_YIELD(pt) ;
+    }
+    PT_END(pt) ;
+}
+
+// === coroutines ====================================================
+
+static coro::task co_counter(void) {
+    while (true) {
+        bench_sink = bench_sink + 1 ;
+        co_await std::suspend_always{} ;
+    }
+}
+
+static coro::task co_yielder(void) {
+    while (!stop) {
+        bench_sink = bench_sink + 1 ;
+        co_await coro::yield() ;
+    }
+}
+
+static coro::task co_nothing(void) {
+    bench_sink = bench_sink + 1 ;
+    co_return ;
+}
+
+static coro::task co_caller(long calls) {
+    for (long i = 0 ; i < calls ; i++) {
+        co_await co_nothing() ;
+    }
+}
+
+int main(void) {
+    printf("context switch, one thread\n") ;
+    struct pt one ;
+    PT_INIT(&one) ;
+    uint64_t pt_ns = BENCH_RUN("protothread yield + resume", "switches", 1, ITERS, pt_counter(&one)) ;
+
+    coro::task t = co_counter() ;
+    std::coroutine_handle<> h = t.release() ;
+    uint64_t co_ns = BENCH_RUN("coroutine suspend + resume", "switches", 1, ITERS, h.resume()) ;
+    h.destroy() ;
+    printf("coroutine / protothread: %.2f\n\n", (double)co_ns / pt_ns) ;
+
+    printf("one pass over four threads\n") ;
+    struct pt four[4] ;
+    for (int i = 0 ; i < 4 ; i++) {
+        PT_INIT(&four[i]) ;
+    }
+    pt_ns = BENCH_RUN("protothreads, round robin", "switches", 4, PASSES,
+                      for (int i = 0 ; i < 4 ; i++) pt_counter(&four[i])) ;
+    for (int i = 0 ; i < 4 ; i++) {
+        coro::spawn(co_yielder()) ;
+    }
+    co_ns = BENCH_RUN("coroutines, coro_exec_run()", "switches", 4, PASSES, coro_exec_run()) ;
+    printf("coroutine / protothread: %.2f\n\n", (double)co_ns / pt_ns) ;
+    stop = true ;
+    coro_exec_run() ; // the yielders end and are freed
+
+    printf("tasks\n") ;
+    BENCH_RUN("spawn + run to end + free", "tasks", 1, PASSES,
+              { coro::spawn(co_nothing()) ; coro_exec_run() ; }) ;
+    coro::spawn(co_caller(ITERS)) ;
+    uint64_t t0 = bench_now_ns() ;
+    coro_exec_run() ; // all the calls in one go
+    bench_report("co_await of a nested task", "calls", 1, ITERS, bench_now_ns() - t0) ;
+    coro_exec_print() ;
+    return 0 ;
+}
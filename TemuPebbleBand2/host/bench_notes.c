@@ -0,0 +1,244 @@
+/**
+ * Host benchmark for the per-frame note update: the game's fix15
+ * update_notes() and check_hit() over the note pool against a copy of
+ * the float, array-of-structs version they replaced (legacy_*), plus a
+ * check that both move the notes to the same pixels at the default
+ * speed, and the cost of clearing every lane.
+ *
+ * The host has an FPU, so the float numbers here are a floor; on the
+ * RP2040 every float add and compare in the legacy loop is a soft-float
+ * library call.
+ */
+#define HOST_SIM
+#include "TemuPebbleBand2.c"
+#include "bench.h"
+
+#define NOTES_PER_LANE 8
+
+// === legacy float notes ============================================
+
+typedef struct legacy_note
+{
+    int lane;
+    float y;
+    int height;
+    int color;
+    bool hit;
+    bool sustain;
+} legacy_note;
+
+static volatile legacy_note legacy_notes[13][50];
+static volatile int legacy_active[13];
+static const float legacy_gravity = 5;
+
+// kinematics of the float update_notes (no note reaches the miss line here)
+static void legacy_update_notes(void)
+{
+    for (int i = 0; i < numLanes; i++)
+    {
+        for (int j = legacy_active[i] - 1; j >= 0; j--)
+        {
+            legacy_notes[i][j].y += legacy_gravity;
+            if ((legacy_notes[i][j].y + legacy_notes[i][j].height) > (SCREEN_HEIGHT - hitHeight + hitWidth))
+            {
+                legacy_notes[i][j].height -= legacy_gravity;
+            }
+            if (legacy_notes[i][j].y > SCREEN_HEIGHT - hitHeight + hitWidth)
+            {
+                numNotesMissed++;
+                continue;
+            }
+            if (legacy_notes[i][j].hit)
+            {
+                legacy_notes[i][j].height -= legacy_gravity;
+            }
+        }
+    }
+}
+
+// the reset loop that used to be pasted into three places
+static void legacy_reset(void)
+{
+    for (int i = 0; i < 13; i++)
+    {
+        legacy_active[i] = 0;
+    }
+    for (int i = 0; i < 13; i++)
+    {
+        for (int j = 0; j < 50; j++)
+        {
+            legacy_notes[i][j].hit = false;
+            legacy_notes[i][j].sustain = false;
+            legacy_notes[i][j].height = SCREEN_HEIGHT;
+            legacy_notes[i][j].y = 0;
+            legacy_notes[i][j].lane = 0;
+            legacy_notes[i][j].color = 0;
+        }
+    }
+}
+
+static bool legacy_check_hit(legacy_note noteObj)
+{
+    return ((noteObj.y + noteObj.height) > (SCREEN_HEIGHT - hitHeight)) && ((noteObj.y + noteObj.height) < (SCREEN_HEIGHT - hitHeight + hitWidth));
+}
+
+// === shared setup ==================================================
+
+// NOTES_PER_LANE notes per lane spread over the top of the track, far
+// enough up that none reach the miss line during a benchmark run
+static void place_notes(void)
+{
+    note_pool_reset();
+    for (int i = 0; i < numLanes; i++)
+    {
+        legacy_active[i] = NOTES_PER_LANE;
+        for (int j = 0; j < NOTES_PER_LANE; j++)
+        {
+            int y = 60 - 2 * hitWidth * j - 3 * i;
+            note_pool_spawn(i, int2fix15(y), hitWidth, RED, true, 0);
+            legacy_notes[i][j].y = y;
+            legacy_notes[i][j].height = hitWidth;
+            legacy_notes[i][j].hit = false;
+            legacy_notes[i][j].sustain = true;
+        }
+    }
+}
+
+static int count_hits(void)
+{
+    int n = 0;
+    for (int i = 0; i < numLanes; i++)
+        for (int j = 0; j < note_lane_count(i); j++)
+            n += (note_lane_id(i, j) != NOTE_NONE) && check_hit(note_lane_id(i, j));
+    return n;
+}
+
+// A press judged the old way: every note in the lane checked against the window
+static int judge_scan(int lane)
+{
+    int n = 0;
+    for (int j = 0; j < note_lane_count(lane); j++)
+        n += check_hit(note_lane_id(lane, j));
+    return n;
+}
+
+// A press judged against the head of the lane only
+static int judge_head(int lane)
+{
+    note_id n = next_note_to_hit(lane, 0); // the notes here have hit time 0
+    return n != NOTE_NONE && check_hit(n);
+}
+
+// Despawning from the middle or the front keeps the rest of the lane in hit order
+static int check_lane_order(void)
+{
+    static const note_id expect[] = {1, NOTE_NONE, 3, 4};
+    note_pool_reset();
+    for (int k = 0; k < 5; k++)
+        note_pool_spawn(0, int2fix15(-40 * k), hitWidth, RED, false, 0);
+    note_pool_despawn(0, 2);
+    note_pool_despawn(0, 0);
+    if (note_lane_count(0) != 4 || note_lane_head(0) != 1)
+        return 1;
+    for (int j = 0; j < 4; j++)
+        if (note_lane_id(0, j) != expect[j])
+            return 1;
+    return 0;
+}
+
+static int legacy_count_hits(void)
+{
+    int n = 0;
+    for (int i = 0; i < numLanes; i++)
+        for (int j = 0; j < legacy_active[i]; j++)
+            n += legacy_check_hit(legacy_notes[i][j]);
+    return n;
+}
+
+// frames the notes can fall before the lowest one gets near the miss line
+#define FRAMES_PER_RUN 40
+
+int main(void)
+{
+    const long iters = 20000;
+    const int active = numLanes * NOTES_PER_LANE;
+    uint64_t slow, fast;
+
+    host_clock_advance(0); // a stopped clock: the notes here, all due at time 0, never expire
+
+    // same pixels as the float version at the default speed
+    place_notes();
+    for (int f = 0; f < FRAMES_PER_RUN; f++)
+    {
+        update_notes();
+        legacy_update_notes();
+        for (int i = 0; i < numLanes; i++)
+            for (int j = 0; j < NOTES_PER_LANE; j++)
+            {
+                note_id n = note_lane_id(i, j);
+                if (noteTop(n) != (int)legacy_notes[i][j].y || notePool.height[n] != legacy_notes[i][j].height)
+                {
+                    printf("frame %d lane %d note %d: fix15 y=%d h=%d, float y=%d h=%d\n", f, i, j,
+                           noteTop(n), notePool.height[n], (int)legacy_notes[i][j].y, legacy_notes[i][j].height);
+                    return 1;
+                }
+            }
+        if (count_hits() != legacy_count_hits())
+        {
+            printf("frame %d: check_hit differs from float version\n", f);
+            return 1;
+        }
+    }
+
+    if (check_lane_order())
+    {
+        printf("lane order lost after despawn\n");
+        return 1;
+    }
+
+    // sub-pixel speed: 2.5 px/frame steps 2, 3, 2, 3...
+    gravity = float2fix15(2.5);
+    place_notes();
+    printf("gravity 2.5 steps:");
+    for (int f = 0; f < 8; f++)
+    {
+        update_notes();
+        printf(" %d", notePool.step[note_lane_id(0, 1)]);
+    }
+    printf("\n");
+    gravity = float2fix15(5.0);
+
+    printf("note update, %d active notes, %d frames per run, %ld runs\n", active, FRAMES_PER_RUN, iters / FRAMES_PER_RUN);
+    slow = BENCH_RUN("update_notes (float structs)", "frames", FRAMES_PER_RUN, iters / FRAMES_PER_RUN,
+                     { place_notes(); for (int f = 0; f < FRAMES_PER_RUN; f++) legacy_update_notes(); });
+    fast = BENCH_RUN("update_notes (fix15 pool)", "frames", FRAMES_PER_RUN, iters / FRAMES_PER_RUN,
+                     { place_notes(); for (int f = 0; f < FRAMES_PER_RUN; f++) update_notes(); });
+    printf("  speedup %.1fx\n", (double)slow / fast);
+    // y += g, y + height, two compares: four soft-float calls per note, more while shrinking
+    printf("  float version on the RP2040: at least %d soft-float calls per frame\n", 4 * active);
+
+    place_notes();
+    for (int f = 0; f < FRAMES_PER_RUN; f++)
+    {
+        update_notes();
+        legacy_update_notes();
+    }
+    slow = BENCH_RUN("check_hit sweep (float)", "sweeps", 1, iters, bench_sink += legacy_count_hits());
+    fast = BENCH_RUN("check_hit sweep (fix15)", "sweeps", 1, iters, bench_sink += count_hits());
+    printf("  speedup %.1fx\n", (double)slow / fast);
+
+    // a full lane, head note in the hit window
+    note_pool_reset();
+    for (int k = 0; k < NOTE_LANE_CAPACITY; k++)
+        note_pool_spawn(5, int2fix15(SCREEN_HEIGHT - hitHeight - 2 * hitWidth * k), hitWidth, RED, false, 0);
+    printf("judging a press in a lane of %d notes\n", note_lane_count(5));
+    slow = BENCH_RUN("judge press (scan lane)", "presses", 1, iters, bench_sink += judge_scan(5));
+    fast = BENCH_RUN("judge press (head of lane)", "presses", 1, iters, bench_sink += judge_head(5));
+    printf("  speedup %.1fx\n", (double)slow / fast);
+
+    printf("note storage: %d bytes of structs, %d bytes of pool\n", (int)sizeof(legacy_notes), (int)sizeof(notePool));
+    slow = BENCH_RUN("reset every lane (loop)", "resets", 1, iters, legacy_reset());
+    fast = BENCH_RUN("reset every lane (generation)", "resets", 1, iters, note_pool_reset());
+    printf("  speedup %.1fx\n", (double)slow / fast);
+    return 0;
+}
@@ -0,0 +1,235 @@
+/**
+ * Host microbenchmarks for the drawing primitives, each against a copy
+ * of the implementation it replaced (kept here as legacy_*), with a
+ * pixel comparison so a speedup never hides a rendering change,
+ * followed by a throughput baseline for every primitive.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "vga16_graphics.h"
+#include "bench.h"
+
+extern unsigned char vga_data_array[] ;
+#define FB_BYTES 153600
+
+// === legacy primitives =============================================
+
+// per-pixel clamping drawPixel
+static void legacy_drawPixel(short x, short y, char color) {
+    if (x > 639) x = 639 ;
+    if (x < 0) x = 0 ;
+    if (y < 0) y = 0 ;
+    if (y > 479) y = 479 ;
+    int pixel = ((640 * y) + x) ;
+    if (pixel & 1) {
+        vga_data_array[pixel>>1] = (vga_data_array[pixel>>1] & 0x0F) | (color << 4) ;
+    }
+    else {
+        vga_data_array[pixel>>1] = (vga_data_array[pixel>>1] & 0xF0) | (color) ;
+    }
+}
+
+// unclipped, column-major fillRect
+static void legacy_fillRect(short x, short y, short w, short h, char color) {
+    for(int i=x; i<(x+w); i++) {
+        for(int j=y; j<(y+h); j++) {
+            legacy_drawPixel(i, j, color);
+        }
+    }
+}
+
+// column-wise circle fill (drawVLine per column)
+static void legacy_fillCircleHelper(short x0, short y0, short r, unsigned char cornername, short delta, char color) {
+  short f     = 1 - r;
+  short ddF_x = 1;
+  short ddF_y = -2 * r;
+  short x     = 0;
+  short y     = r;
+
+  while (x<y) {
+    if (f >= 0) {
+      y--;
+      ddF_y += 2;
+      f     += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f     += ddF_x;
+
+    if (cornername & 0x1) {
+      drawVLine(x0+x, y0-y, 2*y+1+delta, color);
+      drawVLine(x0+y, y0-x, 2*x+1+delta, color);
+    }
+    if (cornername & 0x2) {
+      drawVLine(x0-x, y0-y, 2*y+1+delta, color);
+      drawVLine(x0-y, y0-x, 2*x+1+delta, color);
+    }
+  }
+}
+
+static void legacy_fillCircle(short x0, short y0, short r, char color) {
+  drawVLine(x0, y0-r, 2*r+1, color);
+  legacy_fillCircleHelper(x0, y0, r, 3, 0, color);
+}
+
+static void legacy_fillRoundRect(short x, short y, short w, short h, short r, char color) {
+  fillRect(x+r, y, w-2*r, h, color);
+  legacy_fillCircleHelper(x+w-r-1, y+r, r, 1, h-2*r-1, color);
+  legacy_fillCircleHelper(x+r    , y+r, r, 2, h-2*r-1, color);
+}
+
+// === note spawn path ===============================================
+// One lane's note from spawn (y = -height) until it is fully on screen,
+// drawn the way draw_notes does it: erase the top band, draw the bottom.
+
+#define LANE_X(i) (320 - 213/2 + (i) * 213/13 + 2)
+#define LANE_W (213/13 - 2)
+#define NOTE_H 40
+#define GRAVITY 5
+
+typedef void (*fill_fn)(short, short, short, short, char) ;
+
+static void spawn_path(fill_fn fill) {
+    for (int lane = 0; lane < 13; lane++) {
+        for (int y = -NOTE_H; y <= 0; y += GRAVITY) {
+            fill(LANE_X(lane), y, LANE_W, GRAVITY, BLACK) ;
+            fill(LANE_X(lane), y + GRAVITY + NOTE_H - GRAVITY, LANE_W, GRAVITY, CYAN) ;
+        }
+    }
+}
+
+static void spawn_offscreen(fill_fn fill) {
+    // the first frames of a spawn are completely above the screen
+    for (int lane = 0; lane < 13; lane++) {
+        fill(LANE_X(lane), -NOTE_H, LANE_W, GRAVITY, BLACK) ;
+        fill(LANE_X(lane), -GRAVITY, LANE_W, GRAVITY, CYAN) ;
+    }
+}
+
+// number of bytes of row 0 that differ from a cleared screen
+static int row0_writes(void) {
+    int n = 0 ;
+    for (int i = 0; i < 320; i++) n += (vga_data_array[i] != 0) ;
+    return n ;
+}
+
+static int compare_fill(short x, short y, short w, short h) {
+    static unsigned char ref[FB_BYTES] ;
+    memset(vga_data_array, 0x11, FB_BYTES) ;
+    legacy_fillRect(x, y, w, h, MAGENTA) ;
+    memcpy(ref, vga_data_array, FB_BYTES) ;
+    memset(vga_data_array, 0x11, FB_BYTES) ;
+    fillRect(x, y, w, h, MAGENTA) ;
+    return memcmp(ref, vga_data_array, FB_BYTES) ;
+}
+
+// draw with the legacy and current versions; nonzero if pixels differ
+#define COMPARE(legacy_call, call) ({ \
+    static unsigned char _ref[FB_BYTES] ; \
+    memset(vga_data_array, 0x11, FB_BYTES) ; legacy_call ; \
+    memcpy(_ref, vga_data_array, FB_BYTES) ; \
+    memset(vga_data_array, 0x11, FB_BYTES) ; call ; \
+    memcmp(_ref, vga_data_array, FB_BYTES) ; })
+
+static int compare_round(void) {
+    for (short r = 0; r <= 60; r++) {
+        for (short x = 200; x < 202; x++) {
+            if (COMPARE(legacy_fillCircle(x, 240, r, CYAN), fillCircle(x, 240, r, CYAN)) ||
+                COMPARE(legacy_fillRoundRect(x, 100, 2*r + 31, 2*r + 9, r, CYAN),
+                        fillRoundRect(x, 100, 2*r + 31, 2*r + 9, r, CYAN)) ||
+                // at r == 1 the column walk also painted the center column
+                (r > 1 && COMPARE(legacy_fillCircleHelper(x, 240, r, 1, 7, CYAN), fillCircleHelper(x, 240, r, 1, 7, CYAN))) ||
+                (r > 1 && COMPARE(legacy_fillCircleHelper(x, 240, r, 2, 7, CYAN), fillCircleHelper(x, 240, r, 2, 7, CYAN)))) {
+                printf("round fill differs from legacy at r=%d x=%d\n", r, x) ;
+                return 1 ;
+            }
+        }
+    }
+    return 0 ;
+}
+
+// Baseline throughput for every primitive, so a change to any of them
+// shows up as a number here before it shows up as a slow frame.
+static unsigned short bench_picture[64 * 64] ;
+
+static void bench_all_primitives(long iters) {
+    static char text[] = "Notes Hit:0123" ;
+    for (int i = 0; i < 64 * 64; i++) bench_picture[i] = i & 15 ;
+    setGlyphCache(0) ;
+    setTextColor2(WHITE, BLACK) ;
+    setTextSize(1) ;
+
+    printf("all primitives, %ld iterations\n", iters) ;
+    BENCH_RUN("drawPixel", "pixels", 640, iters, for (short x = 0; x < 640; x++) drawPixel(x, 200, RED)) ;
+    BENCH_RUN("drawHLine 640", "lines", 1, iters, drawHLine(0, 200, 640, RED)) ;
+    BENCH_RUN("drawVLine 480", "lines", 1, iters, drawVLine(320, 0, 480, RED)) ;
+    BENCH_RUN("drawLine diagonal", "lines", 1, iters, drawLine(0, 0, 639, 479, RED)) ;
+    BENCH_RUN("drawRect 200x100", "rects", 1, iters, drawRect(100, 100, 200, 100, RED)) ;
+    BENCH_RUN("fillRect 16x40 note", "rects", 1, iters, fillRect(LANE_X(3), 200, 16, 40, RED)) ;
+    BENCH_RUN("drawCircle r=60", "circles", 1, iters, drawCircle(320, 240, 60, RED)) ;
+    BENCH_RUN("fillCircle r=60", "circles", 1, iters, fillCircle(320, 240, 60, RED)) ;
+    BENCH_RUN("drawRoundRect 400x30 r=10", "rects", 1, iters, drawRoundRect(100, 320, 400, 30, 10, RED)) ;
+    BENCH_RUN("fillRoundRect 400x30 r=10", "rects", 1, iters, fillRoundRect(100, 320, 400, 30, 10, RED)) ;
+    BENCH_RUN("drawChar size 2", "chars", 1, iters, drawChar(100, 100, 'A', WHITE, BLACK, 2)) ;
+    BENCH_RUN("drawCharBig", "chars", 1, iters, drawCharBig(100, 100, 'A', WHITE, BLACK)) ;
+    BENCH_RUN("writeString 14 chars", "chars", 14, iters, { setCursor(10, 10) ; writeString(text) ; }) ;
+    setGlyphCache(1) ;
+    BENCH_RUN("writeString 14 chars (cached)", "chars", 14, iters, { setCursor(10, 10) ; writeString(text) ; }) ;
+    setGlyphCache(0) ;
+    BENCH_RUN("drawPicture 64x64", "pictures", 1, iters, drawPicture(200, 200, bench_picture, 64, 64)) ;
+}
+
+int main(void) {
+    const long iters = 2000 ;
+    uint64_t slow, fast ;
+
+    // on-screen rectangles must match pixel for pixel (both x parities)
+    if (compare_fill(101, 50, 17, 9) || compare_fill(100, 50, 16, 9) || compare_fill(0, 0, 640, 480)) {
+        printf("fillRect output differs from legacy fillRect\n") ;
+        return 1 ;
+    }
+
+    if (compare_round()) {
+        return 1 ;
+    }
+
+    // off-screen spawns: legacy smears onto row 0, clipped version does not
+    memset(vga_data_array, 0, FB_BYTES) ;
+    spawn_offscreen(legacy_fillRect) ;
+    printf("note spawn above screen: legacy wrote %d bytes of row 0, ", row0_writes()) ;
+    memset(vga_data_array, 0, FB_BYTES) ;
+    spawn_offscreen(fillRect) ;
+    printf("clipped wrote %d\n", row0_writes()) ;
+
+    printf("primitives, %ld iterations\n", iters) ;
+    slow = BENCH_RUN("spawn above screen (legacy)", "notes", 13, iters, spawn_offscreen(legacy_fillRect)) ;
+    fast = BENCH_RUN("spawn above screen (clipped)", "notes", 13, iters, spawn_offscreen(fillRect)) ;
+    printf("  speedup %.1fx\n", (double)slow / fast) ;
+
+    slow = BENCH_RUN("spawn until visible (legacy)", "notes", 13, iters, spawn_path(legacy_fillRect)) ;
+    fast = BENCH_RUN("spawn until visible (clipped)", "notes", 13, iters, spawn_path(fillRect)) ;
+    printf("  speedup %.1fx\n", (double)slow / fast) ;
+
+    slow = BENCH_RUN("fillCircle r=8 note head (columns)", "circles", 13, iters,
+                     for (int l = 0; l < 13; l++) legacy_fillCircle(LANE_X(l) + 8, 300, 8, YELLOW)) ;
+    fast = BENCH_RUN("fillCircle r=8 note head (spans)", "circles", 13, iters,
+                     for (int l = 0; l < 13; l++) fillCircle(LANE_X(l) + 8, 300, 8, YELLOW)) ;
+    printf("  speedup %.1fx\n", (double)slow / fast) ;
+
+    slow = BENCH_RUN("fillCircle r=60 (columns)", "circles", 1, iters, legacy_fillCircle(320, 240, 60, YELLOW)) ;
+    fast = BENCH_RUN("fillCircle r=60 (spans)", "circles", 1, iters, fillCircle(320, 240, 60, YELLOW)) ;
+    printf("  speedup %.1fx\n", (double)slow / fast) ;
+
+    slow = BENCH_RUN("fillRoundRect 400x30 r=10 (columns)", "buttons", 1, iters,
+                     legacy_fillRoundRect(100, 320, 400, 30, 10, BLUE)) ;
+    fast = BENCH_RUN("fillRoundRect 400x30 r=10 (spans)", "buttons", 1, iters,
+                     fillRoundRect(100, 320, 400, 30, 10, BLUE)) ;
+    printf("  speedup %.1fx\n", (double)slow / fast) ;
+
+    slow = BENCH_RUN("fillRect 640x480 (legacy)", "frames", 1, iters/20, legacy_fillRect(0, 0, 640, 480, BLACK)) ;
+    fast = BENCH_RUN("fillRect 640x480 (spans)", "frames", 1, iters/20, fillRect(0, 0, 640, 480, BLACK)) ;
+    printf("  speedup %.1fx\n", (double)slow / fast) ;
+
+    bench_all_primitives(iters) ;
+    return 0 ;
+}
@@ -0,0 +1,155 @@
+/**
+ * Host benchmark for the protothread schedulers: runs a set of threads
+ * shaped like the game's (two 1 ms input scanners, a 10 ms chart poll,
+ * a 30 ms frame with some work in it, a 50 ms blink and a thread woken
+ * by an event the frame signals) on the real clock under
+ * SCHED_ROUND_ROBIN and then SCHED_DEADLINE, and prints for each how
+ * often the threads were called against how often they had work, the
+ * CPU time the whole run took, each thread's wake-up lateness and how
+ * long the event took from pt_event_signal() to the thread it woke.
+ *
+ *   bench_sched [SECONDS]   (default 2 per scheduler)
+ *
+ * Round robin calls every thread on every pass and never sleeps, so it
+ * burns a whole core; the deadline scheduler only calls a sleeping
+ * thread once it is due and sleeps in between. Each scheduler runs in
+ * its own child process, since neither ever returns. Its sleeps are
+ * nanosleep() here, which can overshoot by hundreds of microseconds, so
+ * the deadline lateness is mostly the host's; the RP2040's timer alarm
+ * wakes on time.
+ */
+#define HOST_SIM
+#include "TemuPebbleBand2.c"
+#include "bench.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define EVENT_FRAME (1u << 0)
+
+static uint64_t bench_end_us ;
+static uint64_t signal_us ;                 // when the frame signalled
+static uint64_t event_late_us, event_max_us ; // signal to waiter running
+static long events ;
+
+// some work, so the frame thread takes time like the game's does
+static void frame_work(void) {
+    for (int i = 0 ; i < 20000 ; i++) {
+        bench_sink += i * 7 ;
+    }
+}
+
+static PT_THREAD (bench_scan_a(struct pt *pt)) {
+    PT_BEGIN(pt) ;
+    while (1) {
+        bench_sink++ ;
+        PT_YIELD_usec(1000) ;
+    }
+    PT_END(pt) ;
+}
+
+static PT_THREAD (bench_scan_b(struct pt *pt)) {
+    PT_BEGIN(pt) ;
+    while (1) {
+        bench_sink++ ;
+        PT_YIELD_usec(1000) ;
+    }
+    PT_END(pt) ;
+}
+
+static PT_THREAD (bench_chart(struct pt *pt)) {
+    PT_BEGIN(pt) ;
+    while (1) {
+        bench_sink++ ;
+        PT_YIELD_usec(10000) ;
+    }
+    PT_END(pt) ;
+}
+
+// fixed 30 ms ticks on absolute deadlines, as the animation loop does
+static PT_THREAD (bench_frame(struct pt *pt)) {
+    PT_BEGIN(pt) ;
+    static uint64_t tick ;
+    tick = time_us_64() ;
+    while (1) {
+        frame_work() ;
+        signal_us = time_us_64() ;
+        pt_event_signal(EVENT_FRAME) ;
+        tick += 30000 ;
+        PT_YIELD_UNTIL_usec(tick) ;
+    }
+    PT_END(pt) ;
+}
+
+// waits on an event rather than a time
+static PT_THREAD (bench_waiter(struct pt *pt)) {
+    PT_BEGIN(pt) ;
+    while (1) {
+        PT_YIELD_EVENT(EVENT_FRAME) ;
+        uint64_t late = time_us_64() - signal_us ;
+        event_late_us += late ;
+        if (late > event_max_us) event_max_us = late ;
+        events++ ;
+    }
+    PT_END(pt) ;
+}
+
+static PT_THREAD (bench_blink(struct pt *pt)) {
+    PT_BEGIN(pt) ;
+    while (1) {
+        bench_sink++ ;
+        PT_YIELD_usec(50000) ;
+    }
+    PT_END(pt) ;
+}
+
+// ends the run: prints the stats and leaves the child process
+static PT_THREAD (bench_stop(struct pt *pt)) {
+    PT_BEGIN(pt) ;
+    PT_YIELD_UNTIL_usec(bench_end_us) ;
+    struct timespec cpu ;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu) ;
+    uint64_t calls = 0, runs = 0 ;
+    for (int i = 0 ; i < pt_task_count ; i++) {
+        calls += pt_stats[i].calls ;
+        runs += pt_stats[i].runs ;
+    }
+    printf("%lu calls for %lu runs, %.3f s of CPU\n", (unsigned long)calls, (unsigned long)runs,
+           cpu.tv_sec + cpu.tv_nsec / 1e9) ;
+    pt_stats_print(0) ;
+    printf("%ld events, signal to waiter avg %lu us, max %lu us\n", events,
+           (unsigned long)(events ? event_late_us / events : 0), (unsigned long)event_max_us) ;
+    fflush(stdout) ;
+    exit(0) ;
+    PT_END(pt) ;
+}
+
+static void run(int method, const char *name, double seconds) {
+    fflush(stdout) ;
+    pid_t pid = fork() ;
+    if (pid == 0) {
+        printf("\n%s\n", name) ;
+        pt_sched_method = method ;
+        bench_end_us = time_us_64() + (uint64_t)(seconds * 1e6) ;
+        pt_add_thread(bench_scan_a) ;
+        pt_add_thread(bench_scan_b) ;
+        pt_add_thread(bench_chart) ;
+        pt_add_thread(bench_frame) ;
+        pt_add_thread(bench_waiter) ;
+        pt_add_thread(bench_blink) ;
+        pt_add_thread(bench_stop) ;
+        pt_schedule_start ;
+        exit(1) ; // the schedulers never return
+    }
+    waitpid(pid, NULL, 0) ;
+}
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 2 ;
+    if (seconds <= 0) {
+        printf("usage: %s [SECONDS]\n", argv[0]) ;
+        return 2 ;
+    }
+    run(SCHED_ROUND_ROBIN, "round robin", seconds) ;
+    run(SCHED_DEADLINE, "deadline", seconds) ;
+    return 0 ;
+}
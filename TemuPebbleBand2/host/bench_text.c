@@ -0,0 +1,82 @@
+/**
+ * Host benchmark for text rendering: characters per second through
+ * drawChar / drawCharBig with the glyph cache on and off, for the text
+ * the game actually draws every frame (HUD digits and judgement banners).
+ */
+#include <string.h>
+#include "vga16_graphics.h"
+#include "bench.h"
+
+extern unsigned char vga_data_array[] ;
+#define FB_BYTES 153600
+
+static const char *hud = "0123456789" ;
+static const char *banner = "PERFECT!" ;
+
+static void draw_line(const char *str, short x, short y, unsigned char size, char fg, char bg) {
+    for (; *str; str++, x += 6*size) {
+        drawChar(x, y, *str, fg, bg, size) ;
+    }
+}
+
+static void draw_big(const char *str, short x, short y, char fg, char bg) {
+    for (; *str; str++, x += 8) {
+        drawCharBig(x, y, *str, fg, bg) ;
+    }
+}
+
+int main(void) {
+    static unsigned char reference[FB_BYTES] ;
+    const long iters = 20000 ;
+    uint64_t slow, fast ;
+
+    // every pixel written by the cache must match the per-pixel path,
+    // at both even and odd x
+    for (int pass = 0; pass < 2; pass++) {
+        setGlyphCache(pass) ;
+        memset(vga_data_array, 0x5A, FB_BYTES) ;
+        for (short x = 0; x < 2; x++) {
+            draw_line(hud, 10 + x, 10 + 40*x, 1, WHITE, BLACK) ;
+            draw_line(hud, 10 + x, 20 + 40*x, 2, WHITE, BLACK) ;
+            draw_line(banner, 300 + x, 20 + 40*x, 2, WHITE, RED) ;
+            draw_big(banner, 300 + x, 100 + 40*x, YELLOW, BLUE) ;
+        }
+        if (pass == 0) {
+            memcpy(reference, vga_data_array, FB_BYTES) ;
+        }
+        else if (memcmp(reference, vga_data_array, FB_BYTES) != 0) {
+            printf("glyph cache output differs from drawChar\n") ;
+            return 1 ;
+        }
+    }
+
+    printf("text rendering, %ld iterations\n", iters) ;
+    setGlyphCache(0) ;
+    slow = BENCH_RUN("drawChar size 1 (per pixel)", "chars", 10, iters, draw_line(hud, 11, 10, 1, WHITE, BLACK)) ;
+    setGlyphCache(1) ;
+    fast = BENCH_RUN("drawChar size 1 (glyph cache)", "chars", 10, iters, draw_line(hud, 11, 10, 1, WHITE, BLACK)) ;
+    printf("  speedup %.1fx\n", (double)slow / fast) ;
+
+    setGlyphCache(0) ;
+    slow = BENCH_RUN("drawChar size 2 (per pixel)", "chars", 10, iters, draw_line(hud, 130, 10, 2, WHITE, BLACK)) ;
+    setGlyphCache(1) ;
+    fast = BENCH_RUN("drawChar size 2 (glyph cache)", "chars", 10, iters, draw_line(hud, 130, 10, 2, WHITE, BLACK)) ;
+    printf("  speedup %.1fx\n", (double)slow / fast) ;
+
+    setGlyphCache(0) ;
+    slow = BENCH_RUN("banner size 2 (per pixel)", "chars", 8, iters, draw_line(banner, 540, 10, 2, WHITE, GREEN)) ;
+    setGlyphCache(1) ;
+    fast = BENCH_RUN("banner size 2 (glyph cache)", "chars", 8, iters, draw_line(banner, 540, 10, 2, WHITE, GREEN)) ;
+    printf("  speedup %.1fx\n", (double)slow / fast) ;
+
+    setGlyphCache(0) ;
+    slow = BENCH_RUN("drawCharBig (per pixel)", "chars", 8, iters, draw_big(banner, 300, 100, YELLOW, BLUE)) ;
+    setGlyphCache(1) ;
+    fast = BENCH_RUN("drawCharBig (glyph cache)", "chars", 8, iters, draw_big(banner, 300, 100, YELLOW, BLUE)) ;
+    printf("  speedup %.1fx\n", (double)slow / fast) ;
+
+    unsigned long hits, misses ;
+    getGlyphCacheStats(&hits, &misses) ;
+    printf("glyph cache: %lu hits, %lu misses\n", hits, misses) ;
+    return 0 ;
+}
@@ -0,0 +1,149 @@
+/**
+ * Saving and comparing the simulated VGA frame buffer -- see framebuffer.h
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "framebuffer.h"
+
+// same order as enum colors in vga16_graphics.h
+const unsigned char fb_palette[16][3] = {
+    {0, 0, 0}, {0, 187, 0}, {0, 132, 0}, {0, 255, 0},
+    {0, 0, 255}, {0, 187, 255}, {0, 132, 255}, {0, 255, 255},
+    {255, 0, 0}, {255, 187, 0}, {255, 132, 9}, {255, 255, 0},
+    {255, 0, 255}, {255, 187, 255}, {255, 132, 255}, {255, 255, 255}
+} ;
+
+unsigned char fb_pixel(int x, int y) {
+    int pixel = FB_WIDTH * y + x ;
+    unsigned char b = vga_data_array[pixel >> 1] ;
+    return (pixel & 1) ? (b >> 4) : (b & 0x0F) ;
+}
+
+// Binary PPM (P6). Returns 0 on success.
+int fb_save_ppm(const char *path) {
+    FILE *f = fopen(path, "wb") ;
+    if (!f) return -1 ;
+    fprintf(f, "P6\n%d %d\n255\n", FB_WIDTH, FB_HEIGHT) ;
+    for (int y = 0; y < FB_HEIGHT; y++) {
+        for (int x = 0; x < FB_WIDTH; x++) {
+            fwrite(fb_palette[fb_pixel(x, y)], 1, 3, f) ;
+        }
+    }
+    return fclose(f) ;
+}
+
+// === PNG ===========================================================
+// 4-bit indexed PNG with the palette above. The image data is written
+// as stored (uncompressed) deflate blocks, so no zlib is needed.
+
+static uint32_t crc_table[256] ;
+
+static uint32_t crc32_update(uint32_t crc, const unsigned char *buf, size_t len) {
+    if (!crc_table[1]) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n ;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1 ;
+            crc_table[n] = c ;
+        }
+    }
+    crc = ~crc ;
+    while (len--) crc = crc_table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8) ;
+    return ~crc ;
+}
+
+static void put_be32(unsigned char *p, uint32_t v) {
+    p[0] = v >> 24 ; p[1] = v >> 16 ; p[2] = v >> 8 ; p[3] = v ;
+}
+
+static void write_chunk(FILE *f, const char *type, const unsigned char *data, uint32_t len) {
+    unsigned char hdr[8] ;
+    put_be32(hdr, len) ;
+    memcpy(hdr + 4, type, 4) ;
+    fwrite(hdr, 1, 8, f) ;
+    fwrite(data, 1, len, f) ;
+    uint32_t crc = crc32_update(crc32_update(0, hdr + 4, 4), data, len) ;
+    put_be32(hdr, crc) ;
+    fwrite(hdr, 1, 4, f) ;
+}
+
+int fb_save_png(const char *path) {
+    // raw scanlines: filter byte 0, then 320 bytes of left-pixel-high nibbles
+    enum { ROW = 1 + FB_WIDTH / 2, RAW = ROW * FB_HEIGHT, BLOCK = 65535 } ;
+    enum { NBLOCKS = (RAW + BLOCK - 1) / BLOCK } ;
+    static unsigned char raw[RAW] ;
+    static unsigned char idat[2 + RAW + 5 * NBLOCKS + 4] ;
+
+    for (int y = 0; y < FB_HEIGHT; y++) {
+        unsigned char *row = &raw[y * ROW] ;
+        row[0] = 0 ;
+        for (int i = 0; i < FB_WIDTH / 2; i++) {
+            unsigned char b = vga_data_array[y * (FB_WIDTH / 2) + i] ;
+            row[1 + i] = (b << 4) | (b >> 4) ;
+        }
+    }
+
+    // zlib stream of stored blocks
+    size_t n = 0 ;
+    idat[n++] = 0x78 ;
+    idat[n++] = 0x01 ;
+    for (size_t off = 0; off < RAW; off += BLOCK) {
+        size_t len = (RAW - off < BLOCK) ? RAW - off : BLOCK ;
+        idat[n++] = (off + len == RAW) ? 1 : 0 ;
+        idat[n++] = len & 0xFF ;
+        idat[n++] = len >> 8 ;
+        idat[n++] = ~len & 0xFF ;
+        idat[n++] = (~len >> 8) & 0xFF ;
+        memcpy(&idat[n], &raw[off], len) ;
+        n += len ;
+    }
+    uint32_t a = 1, b = 0 ;
+    for (size_t i = 0; i < RAW; i++) {
+        a = (a + raw[i]) % 65521 ;
+        b = (b + a) % 65521 ;
+    }
+    put_be32(&idat[n], (b << 16) | a) ;
+    n += 4 ;
+
+    FILE *f = fopen(path, "wb") ;
+    if (!f) return -1 ;
+    static const unsigned char sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'} ;
+    unsigned char ihdr[13] ;
+    put_be32(ihdr, FB_WIDTH) ;
+    put_be32(ihdr + 4, FB_HEIGHT) ;
+    ihdr[8] = 4 ;   // bit depth
+    ihdr[9] = 3 ;   // indexed color
+    ihdr[10] = ihdr[11] = ihdr[12] = 0 ;
+    fwrite(sig, 1, 8, f) ;
+    write_chunk(f, "IHDR", ihdr, 13) ;
+    write_chunk(f, "PLTE", &fb_palette[0][0], sizeof(fb_palette)) ;
+    write_chunk(f, "IDAT", idat, n) ;
+    write_chunk(f, "IEND", NULL, 0) ;
+    return fclose(f) ;
+}
+
+// Number of pixels that differ from a PPM written by fb_save_ppm,
+// or -1 if the file is missing or not a 640x480 P6 image.
+long fb_compare_ppm(const char *path) {
+    int w, h, maxval ;
+    FILE *f = fopen(path, "rb") ;
+    if (!f) return -1 ;
+    if (fscanf(f, "P6 %d %d %d", &w, &h, &maxval) != 3 || w != FB_WIDTH || h != FB_HEIGHT || maxval != 255) {
+        fclose(f) ;
+        return -1 ;
+    }
+    fgetc(f) ;
+    long diffs = 0 ;
+    for (int y = 0; y < FB_HEIGHT; y++) {
+        for (int x = 0; x < FB_WIDTH; x++) {
+            unsigned char rgb[3] ;
+            if (fread(rgb, 1, 3, f) != 3) {
+                fclose(f) ;
+                return -1 ;
+            }
+            diffs += memcmp(rgb, fb_palette[fb_pixel(x, y)], 3) != 0 ;
+        }
+    }
+    fclose(f) ;
+    return diffs ;
+}
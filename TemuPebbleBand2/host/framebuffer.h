@@ -0,0 +1,23 @@
+/**
+ * Saving and comparing the simulated VGA frame buffer.
+ *
+ * vga_data_array holds two 4-bit pixels per byte (even x in the low
+ * nibble). Colors are mapped through the same 16-color palette that
+ * picture_generation/picture_decode.py uses.
+ */
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#define FB_WIDTH 640
+#define FB_HEIGHT 480
+#define FB_BYTES (FB_WIDTH * FB_HEIGHT / 2)
+
+extern unsigned char vga_data_array[] ;
+extern const unsigned char fb_palette[16][3] ;
+
+unsigned char fb_pixel(int x, int y) ;
+int fb_save_ppm(const char *path) ;
+int fb_save_png(const char *path) ;
+long fb_compare_ppm(const char *path) ;
+
+#endif
@@ -0,0 +1,23 @@
+# Plays one host/cases/ script and compares sim_game's result line with the
+# script's "# expected:" line. The "#   sim_game ..." line gives the arguments,
+# with paths from the firmware directory. Run by ctest, or by hand:
+#
+#   cmake -DSIM=host/build/sim_game -DCASE=host/cases/taps_5ms.txt -P host/run_case.cmake
+
+file(STRINGS ${CASE} lines)
+foreach(line IN LISTS lines)
+    if(line MATCHES "^#[ ]+sim_game (.*)$")
+        separate_arguments(args UNIX_COMMAND "${CMAKE_MATCH_1}")
+    elseif(line MATCHES "^# expected: (.*)$")
+        set(expected "${CMAKE_MATCH_1}")
+    endif()
+endforeach()
+if(NOT DEFINED args OR NOT DEFINED expected)
+    message(FATAL_ERROR "${CASE}: no \"#   sim_game\" or \"# expected:\" line")
+endif()
+
+execute_process(COMMAND ${SIM} ${args} OUTPUT_VARIABLE output RESULT_VARIABLE status)
+string(REGEX MATCH "^[^\n]*" result "${output}")
+if(NOT status EQUAL 0 OR NOT result STREQUAL expected)
+    message(FATAL_ERROR "${CASE}\n  expected: ${expected}\n  got:      ${result} (exit ${status})")
+endif()
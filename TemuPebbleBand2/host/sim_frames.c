@@ -0,0 +1,131 @@
+/**
+ * Host frame simulator: runs the game's real drawing code (menu,
+ * background, piano, falling notes, HUD, judgement banners, end screen)
+ * against the in-memory vga_data_array and saves each scene as PNG and
+ * PPM using the VGA palette.
+ *
+ *   sim_frames OUTDIR [GOLDENDIR]
+ *
+ * With GOLDENDIR, every scene is also compared pixel for pixel with
+ * GOLDENDIR/<scene>.ppm and the exit status is 1 if any scene differs,
+ * so a directory of accepted frames works as a regression test.
+ */
+#define HOST_SIM
+#include "TemuPebbleBand2.c"
+#include "framebuffer.h"
+
+static const char *out_dir ;
+static const char *golden_dir ;
+static int failures ;
+
+static void save_scene(const char *name) {
+    char path[512] ;
+    snprintf(path, sizeof(path), "%s/%s.png", out_dir, name) ;
+    fb_save_png(path) ;
+    snprintf(path, sizeof(path), "%s/%s.ppm", out_dir, name) ;
+    fb_save_ppm(path) ;
+
+    if (golden_dir) {
+        snprintf(path, sizeof(path), "%s/%s.ppm", golden_dir, name) ;
+        long diffs = fb_compare_ppm(path) ;
+        if (diffs != 0) {
+            failures++ ;
+        }
+        if (diffs < 0) {
+            printf("%-16s no golden image at %s\n", name, path) ;
+        }
+        else {
+            printf("%-16s %ld pixels differ\n", name, diffs) ;
+        }
+    }
+    else {
+        printf("%-16s saved\n", name) ;
+    }
+}
+
+// One pass of the animation protothread: queue a frame, draw it, yield for a frame, resume
+static void run_frame(struct pt *pt) {
+    protothread_animation_loop(pt) ;
+    render_queue_drain() ;
+    host_clock_advance(30000) ;
+    protothread_animation_loop(pt) ;
+    render_queue_drain() ;
+}
+
+static int any_hittable(void) {
+    for (int lane = 0; lane < numLanes; lane++) {
+        note_id n = next_note_to_hit(lane, time_us_32()) ;
+        if (n != NOTE_NONE && check_hit(n)) {
+            return 1 ;
+        }
+    }
+    return 0 ;
+}
+
+int main(int argc, char **argv) {
+    struct pt pt ;
+    if (argc < 2) {
+        printf("usage: %s OUTDIR [GOLDENDIR]\n", argv[0]) ;
+        return 2 ;
+    }
+    out_dir = argv[1] ;
+    golden_dir = (argc > 2) ? argv[2] : NULL ;
+    host_clock_advance(0) ;
+    render_queue_init(render_execute, 0) ; // drawn here, after each frame
+    PT_INIT(&pt) ;
+
+    // main menu, cursor on the second entry
+    menu_state = 0 ;
+    menu_selection = 1 ;
+    run_frame(&pt) ;
+    save_scene("menu") ;
+
+    // game with lives, before any notes
+    menu_state = 1 ;
+    setup = false ;
+    lives = 3 ;
+    currentChart = chart_great_fairy_fountain ;
+    run_frame(&pt) ;
+    save_scene("game_start") ;
+
+    // a staggered set of notes, one of them sustained
+    for (int frame = 0; frame < 40; frame++) {
+        if (frame % 4 == 0 && frame < 32) {
+            int lane = (frame / 4 * 5) % 13 ;
+            int sustain = (frame == 8) ;
+            spawn_note(lane, sustain ? YELLOW : (frame / 4) % 15 + 1, sustain ? 2 * hitWidth : hitWidth, sustain,
+                       time_us_32() + note_lead_us()) ;
+        }
+        run_frame(&pt) ;
+    }
+    save_scene("game_notes") ;
+
+    // fall until the first note reaches the hit area
+    for (int frame = 0; frame < 40 && !any_hittable(); frame++) {
+        run_frame(&pt) ;
+    }
+
+    // press every lane that has a note in the hit window, as the piano scanner
+    // would; the next frame hands the events to the game
+    for (int lane = 0; lane < numLanes; lane++) {
+        note_id n = next_note_to_hit(lane, time_us_32()) ;
+        if (n != NOTE_NONE && check_hit(n)) {
+            key_edge press = { lane, 1, time_us_32() } ;
+            input_ring_push(&pianoEvents, INPUT_PIANO, &press) ;
+        }
+    }
+    run_frame(&pt) ;
+    save_scene("game_hit") ;
+
+    // let everything else fall through as misses
+    for (int frame = 0; frame < 60; frame++) {
+        run_frame(&pt) ;
+    }
+    save_scene("game_miss") ;
+
+    draw_end_screen() ;
+    render_queue_drain() ;
+    save_scene("end_screen") ;
+
+    return failures ? 1 : 0 ;
+}
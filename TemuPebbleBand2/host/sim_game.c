@@ -0,0 +1,284 @@
+/**
+ * Headless game simulator: plays whole games through the real game loop
+ * (chart thread, animation loop, input dispatch, judging, renderer) on
+ * the virtual clock, as fast as the host can run them, and prints each
+ * game's result.
+ *
+ *   sim_game [-s SELECTION] [-c CHART] [-o OFFSET_MS] [-i INPUT] [-n RUNS] [-d] [-t STEP_US] [-r]
+ *
+ *   -s  menu entry to start: 0 endless, 1 with lives, 2 second song (default 0)
+ *   -c  play CHART, a binary chart (midi_to_chart.py --bin), instead of the
+ *       selection's song
+ *   -o  autoplay: press every note OFFSET_MS after its hit time (default 0)
+ *   -i  play INPUT instead of autoplaying. INPUT is either a recording
+ *       dumped by the firmware (its "rec" lines, other lines are skipped)
+ *       or a script of "MS KEY DOWN" lines: song time in milliseconds,
+ *       piano key from 0, 1 for a press and 0 for a release
+ *   -n  play the game RUNS times, for timing (default 1)
+ *   -d  skip drawing: render commands are queued and discarded
+ *   -t  virtual clock step in microseconds (default 1000)
+ *   -r  print the first game's recording, in the form -i reads
+ *
+ * The result line is the same for every run of the same input, so it can
+ * be compared against an accepted one as a regression test for a chart.
+ * host/cases/ holds such charts and scripts, each with its expected result.
+ */
+#define HOST_SIM
+#include "TemuPebbleBand2.c"
+#include "bench.h"
+#include <unistd.h>
+
+static int selection ;
+static const unsigned char *custom_chart ; // -c, or NULL for the selection's song
+static int offset_us ;
+static int step_us = 1000 ;
+
+// autoplay: the hit time of the last note pressed and when to let go, per lane
+static uint32_t pressed_hit[13] ;
+static uint32_t release_at[13] ;
+static bool holding[13] ;
+
+static void push_piano(int key, int down, uint32_t time_us) {
+    key_edge edge = { key, down, time_us } ;
+    input_ring_push(&pianoEvents, INPUT_PIANO, &edge) ;
+}
+
+// The next note autoplay has not pressed in a lane. Like next_note_to_hit(),
+// but the judge cursor is left alone: presses still in the input ring, from
+// earlier in this game tick, have yet to be judged where it is.
+static note_id next_to_press(int lane, uint32_t now) {
+    for (int j = notePool.laneJudge[lane]; j < note_lane_count(lane); j++) {
+        note_id n = note_lane_id(lane, j) ;
+        if (n != NOTE_NONE && !(notePool.flags[n] & NOTE_JUDGED) &&
+            (int32_t)(notePool.hitTime[n] - pressed_hit[lane]) > 0 &&
+            (int32_t)(now - notePool.hitTime[n]) <= (int32_t)judgeWindowUs[JUDGE_BAD]) {
+            return n ;
+        }
+    }
+    return NOTE_NONE ;
+}
+
+// Presses each lane's next note offset_us after its hit time. A tap is let go
+// on the next tick, so a note close behind it in the lane is pressed in time;
+// a sustain is held until it has played out or the next note in its lane is due.
+static void autoplay(void) {
+    uint32_t now = time_us_32() ;
+    for (int lane = 0; lane < numLanes; lane++) {
+        note_id n = next_to_press(lane, now) ;
+        bool due = n != NOTE_NONE && (int32_t)(now - (notePool.hitTime[n] + offset_us)) >= 0 ;
+        if (holding[lane] && (due || (int32_t)(now - release_at[lane]) >= 0)) {
+            push_piano(lane, 0, now) ;
+            holding[lane] = false ;
+        }
+        if (due && !holding[lane]) {
+            int hold_us = step_us ;
+            if (notePool.flags[n] & NOTE_SUSTAIN) {
+                hold_us = (int)(((long long)int2fix15(notePool.height[n]) * frameTime) / gravity) ;
+                hold_us += 2 * frameTime ; // its last frames too
+            }
+            push_piano(lane, 1, now) ;
+            pressed_hit[lane] = notePool.hitTime[n] ;
+            release_at[lane] = now + hold_us ;
+            holding[lane] = true ;
+        }
+    }
+}
+
+static int compare_records(const void *a, const void *b) {
+    int32_t ta = (int32_t)((const replay_record *)a)->time_us ;
+    int32_t tb = (int32_t)((const replay_record *)b)->time_us ;
+    return (ta > tb) - (ta < tb) ;
+}
+
+// Loads a dumped recording or an input script as the recording replay_game() plays
+static int load_input(const char *path) {
+    static replay_record script[REPLAY_LOG_SIZE] ;
+    int scripted = 0 ;
+    bool started = false ;
+    char line[128] ;
+    FILE *f = fopen(path, "r") ;
+    if (!f) {
+        perror(path) ;
+        return 0 ;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long time ;
+        unsigned int kind, source, key, down ;
+        int ms ;
+        if (sscanf(line, "rec %lx %u %u %u %u", &time, &kind, &source, &key, &down) == 5) {
+            if (kind == REPLAY_START) {
+                replay_record_start(source, (int8_t)key, time) ;
+                started = true ;
+            }
+            else if (kind == REPLAY_SETTING && started) {
+                replay_record_setting(source, time) ;
+            }
+            else if (started) {
+                input_event ev = { source, key, down, 0 } ;
+                replay_record_event(&ev, (int32_t)time) ;
+            }
+        }
+        else if (sscanf(line, "%d %u %u", &ms, &key, &down) == 3 && scripted < REPLAY_LOG_SIZE - 1) {
+            replay_record rec = { (uint32_t)(ms * 1000), REPLAY_EVENT, INPUT_PIANO, key, down } ;
+            script[scripted++] = rec ;
+        }
+    }
+    fclose(f) ;
+
+    if (!started && scripted) {
+        qsort(script, scripted, sizeof(script[0]), compare_records) ;
+        replay_record_start(selection, (selection == 1) ? 3 : -1, 1) ;
+        for (int i = 0; i < scripted; i++) {
+            input_event ev = { script[i].source, script[i].key, script[i].down, 0 } ;
+            replay_record_event(&ev, (int32_t)script[i].time_us) ;
+        }
+        started = true ;
+    }
+    replay_stop() ;
+    if (!started) {
+        printf("%s: no recording or script lines\n", path) ;
+    }
+    return started ;
+}
+
+// Reads a binary chart for -c
+static const unsigned char *load_chart(const char *path) {
+    static unsigned char data[65536] ;
+    chart_cursor cursor ;
+    FILE *f = fopen(path, "rb") ;
+    if (!f) {
+        perror(path) ;
+        return NULL ;
+    }
+    size_t size = fread(data, 1, sizeof(data), f) ;
+    fclose(f) ;
+    if (size < CHART_HEADER_BYTES || size == sizeof(data) || !chart_open(&cursor, data)) {
+        printf("%s: not a chart, or too big\n", path) ;
+        return NULL ;
+    }
+    return data ;
+}
+
+// -d: nothing is drawn, but frames are still counted
+static void discard_cmd(const render_cmd *cmd) {
+    if (cmd->op == RC_FRAME) {
+        renderFrames++ ;
+    }
+}
+
+// Clears what the end-of-game screen would before the next game
+static void reset_game(void) {
+    judge_reset_session() ;
+    numNotesHit = 0 ;
+    numNotesMissed = 0 ;
+    combo = 0 ;
+    maxCombo = 0 ;
+    lives = -1 ;
+    note_pool_reset() ;
+    replay_stop() ;
+    menu_state = 0 ;
+    setup = true ;
+    for (int lane = 0; lane < 13; lane++) {
+        pressed_hit[lane] = time_us_32() ; // notes due after now are unpressed
+        holding[lane] = false ;
+        pianoKeysPressed[lane] = false ;
+    }
+}
+
+// Plays one game to its end, returns the frames it ran for
+static long play_game(bool replay) {
+    struct pt animation, chart ;
+    PT_INIT(&animation) ;
+    PT_INIT(&chart) ;
+    if (replay) {
+        replay_game() ;
+    }
+    else {
+        start_game(selection) ;
+    }
+    if (custom_chart) {
+        currentChart = custom_chart ;
+        open_chart() ; // in place of the selection's song, from the same moment
+    }
+    while (menu_state == 1) {
+        if (!replay) {
+            autoplay() ;
+        }
+        protothread_chart_notes(&chart) ;
+        if (menu_state != 1) {
+            break ; // song over; the end-of-game report is left to the caller
+        }
+        protothread_animation_loop(&animation) ;
+        render_queue_drain() ;
+        host_clock_advance(step_us) ;
+    }
+    return renderFrames - renderFramesStart ; // counted from the game's setup
+}
+
+int main(int argc, char **argv) {
+    const char *input = NULL ;
+    bool draw = true ;
+    bool dump = false ;
+    long runs = 1 ;
+    int opt ;
+    const char *chart_path = NULL ;
+    while ((opt = getopt(argc, argv, "s:c:o:i:n:dt:r")) != -1) {
+        switch (opt) {
+        case 's': selection = atoi(optarg) ; break ;
+        case 'c': chart_path = optarg ; break ;
+        case 'o': offset_us = atoi(optarg) * 1000 ; break ;
+        case 'i': input = optarg ; break ;
+        case 'n': runs = atol(optarg) ; break ;
+        case 'd': draw = false ; break ;
+        case 't': step_us = atoi(optarg) ; break ;
+        case 'r': dump = true ; break ;
+        default:
+            printf("usage: %s [-s SELECTION] [-c CHART] [-o OFFSET_MS] [-i INPUT] [-n RUNS] [-d] [-t STEP_US] [-r]\n", argv[0]) ;
+            return 2 ;
+        }
+    }
+    if (selection < 0 || selection > 2 || runs < 1 || step_us < 1) {
+        printf("selection must be 0..2, runs and step at least 1\n") ;
+        return 2 ;
+    }
+    host_clock_advance(0) ;
+    render_queue_init(draw ? render_execute : discard_cmd, 0) ;
+    if (chart_path && !(custom_chart = load_chart(chart_path))) {
+        return 1 ;
+    }
+    if (input && !load_input(input)) {
+        return 1 ;
+    }
+
+    uint64_t sim_us = 0, wall_ns = 0 ;
+    long frames = 0 ;
+    for (long run = 0; run < runs; run++) {
+        reset_game() ;
+        uint64_t sim_start = time_us_64() ;
+        uint64_t wall_start = bench_now_ns() ;
+        frames += play_game(input != NULL) ;
+        wall_ns += bench_now_ns() - wall_start ;
+        sim_us += time_us_64() - sim_start ;
+
+        if (run == 0) {
+            if (maxCombo < combo) {
+                maxCombo = combo ; // a combo still running at the end of the song
+            }
+            printf("hit %d, miss %d, max combo %d, perfect %u, good %u, bad %u, mean error %lld us, "
+                   "dropped frames %u%s\n",
+                   numNotesHit, numNotesMissed, maxCombo, judgeSession.grades[JUDGE_PERFECT],
+                   judgeSession.grades[JUDGE_GOOD], judgeSession.grades[JUDGE_BAD],
+                   judgeSession.judged ? (long long)(judgeSession.errorSum / (int64_t)judgeSession.judged) : 0LL,
+                   droppedFrames, lives == 0 ? ", out of lives" : "") ;
+            if (dump) {
+                replay_dump() ;
+            }
+        }
+    }
+
+    double wall_s = wall_ns / 1e9 ;
+    printf("%ld game%s, %.1f s of play in %.3f s: %.0fx real time, %.0f frames/s%s\n",
+           runs, runs == 1 ? "" : "s", sim_us / 1e6, wall_s, (sim_us / 1e6) / wall_s, frames / wall_s,
+           draw ? "" : " (not drawn)") ;
+    return 0 ;
+}
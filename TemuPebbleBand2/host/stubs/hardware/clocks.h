@@ -0,0 +1,4 @@
+#pragma once
+#include "pico_host.h"
+enum clock_index { clk_sys = 5 } ;
+static inline uint32_t clock_get_hz(enum clock_index clk) { (void)clk ; return 125000000 ; }
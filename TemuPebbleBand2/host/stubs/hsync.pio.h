@@ -0,0 +1,4 @@
+// Host stand-in for the pioasm output of hsync.pio
+#include "pico_host.h"
+static const pio_program_t hsync_program ;
+static inline void hsync_program_init(PIO pio, uint sm, uint offset, uint pin) { (void)pio ; (void)sm ; (void)offset ; (void)pin ; }
@@ -0,0 +1,6 @@
+// Host stand-in for the pioasm output of keypad_scan.pio
+#include "pico_host.h"
+static const pio_program_t keypad_scan_program ;
+static inline void keypad_scan_program_init(PIO pio, uint sm, uint offset, uint row_pin, uint col_pin) {
+    (void)pio ; (void)sm ; (void)offset ; (void)row_pin ; (void)col_pin ;
+}
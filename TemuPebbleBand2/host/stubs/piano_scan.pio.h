@@ -0,0 +1,6 @@
+// Host stand-in for the pioasm output of piano_scan.pio
+#include "pico_host.h"
+static const pio_program_t piano_scan_program ;
+static inline void piano_scan_program_init(PIO pio, uint sm, uint offset, uint sel_pin, uint in_pin) {
+    (void)pio ; (void)sm ; (void)offset ; (void)sel_pin ; (void)in_pin ;
+}
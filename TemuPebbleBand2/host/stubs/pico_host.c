@@ -0,0 +1,12 @@
+// Storage for the host stand-ins declared in pico_host.h
+#include "pico_host.h"
+
+bool host_clock_virtual ;
+uint64_t host_clock_us ;
+pio_hw_t host_pio_hw[2] ;
+dma_hw_t host_dma_hw ;
+uint32_t host_gpio_out ;
+uint32_t host_gpio_in ;
+uart_inst_t host_uart[2] ;
+spin_lock_t host_spin_locks[32] ;
+spi_hw_t host_spi_hw[2] ;
@@ -0,0 +1,216 @@
+/**
+ * Host (Linux) stand-ins for the parts of the Pico SDK used by the
+ * graphics library and the game, so they can be built, benchmarked and
+ * rendered to image files on a PC. Hardware setup calls are no-ops and
+ * inputs read as idle; the frame buffer is plain RAM exactly as on the
+ * RP2040.
+ */
+#ifndef PICO_HOST_H
+#define PICO_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+
+typedef unsigned int uint ;
+
+// === time ==========================================================
+// Real monotonic time by default. Simulations switch to a virtual clock
+// that only moves when host_clock_advance() is called, so protothread
+// yields can be stepped deterministically and faster than real time.
+extern bool host_clock_virtual ;
+extern uint64_t host_clock_us ;
+
+static inline uint64_t time_us_64(void) {
+    if (host_clock_virtual) return host_clock_us ;
+    struct timespec ts ;
+    clock_gettime(CLOCK_MONOTONIC, &ts) ;
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u ;
+}
+static inline void host_clock_advance(uint64_t us) {
+    host_clock_virtual = true ;
+    host_clock_us += us ;
+}
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64() ; }
+static inline void sleep_us(uint64_t us) { (void)us ; }
+static inline void sleep_ms(uint32_t ms) { (void)ms ; }
+
+// Waiting for an event: nothing on the host raises one, so a wait runs
+// to its timeout -- instantly on the virtual clock, asleep otherwise
+typedef uint64_t absolute_time_t ;
+static inline absolute_time_t from_us_since_boot(uint64_t us) { return us ; }
+static inline bool best_effort_wfe_or_timeout(absolute_time_t t) {
+    uint64_t now = time_us_64() ;
+    if (t <= now) return true ;
+    if (host_clock_virtual) {
+        host_clock_us = t ;
+        return true ;
+    }
+    struct timespec ts = { (time_t)((t - now) / 1000000u), (long)((t - now) % 1000000u) * 1000 } ;
+    nanosleep(&ts, NULL) ;
+    return true ;
+}
+static inline void __sev(void) { }
+static inline void __wfe(void) { }
+
+// === stdio / cores =================================================
+static inline bool stdio_init_all(void) { return true ; }
+#define PICO_ERROR_TIMEOUT (-1)
+static inline int getchar_timeout_us(uint32_t timeout_us) { (void)timeout_us ; return PICO_ERROR_TIMEOUT ; }
+static inline void stdio_set_chars_available_callback(void (*fn)(void *), void *param) { (void)fn ; (void)param ; }
+static inline uint get_core_num(void) { return 0 ; }
+static inline void tight_loop_contents(void) { }
+
+// === GPIO ==========================================================
+#define GPIO_OUT 1
+#define GPIO_IN 0
+enum gpio_function { GPIO_FUNC_SPI = 1, GPIO_FUNC_UART = 2, GPIO_FUNC_PIO0 = 6, GPIO_FUNC_PIO1 = 7 } ;
+
+extern uint32_t host_gpio_out ;   // last value driven on each pin
+extern uint32_t host_gpio_in ;    // value read back from each pin
+
+static inline void gpio_init(uint gpio) { (void)gpio ; }
+static inline void gpio_init_mask(uint32_t mask) { (void)mask ; }
+static inline void gpio_set_dir(uint gpio, bool out) { (void)gpio ; (void)out ; }
+static inline void gpio_set_dir_out_masked(uint32_t mask) { (void)mask ; }
+static inline void gpio_pull_down(uint gpio) { (void)gpio ; }
+static inline void gpio_set_function(uint gpio, enum gpio_function fn) { (void)gpio ; (void)fn ; }
+static inline void gpio_put(uint gpio, bool value) {
+    host_gpio_out = value ? (host_gpio_out | (1u << gpio)) : (host_gpio_out & ~(1u << gpio)) ;
+}
+static inline void gpio_put_masked(uint32_t mask, uint32_t value) {
+    host_gpio_out = (host_gpio_out & ~mask) | (value & mask) ;
+}
+static inline bool gpio_get(uint gpio) { return (host_gpio_in >> gpio) & 1 ; }
+static inline uint32_t gpio_get_all(void) { return host_gpio_in ; }
+
+// === UART (never has input) ========================================
+typedef struct { int unused ; } uart_inst_t ;
+extern uart_inst_t host_uart[2] ;
+#define uart0 (&host_uart[0])
+#define uart1 (&host_uart[1])
+static inline bool uart_is_readable(uart_inst_t *uart) { (void)uart ; return false ; }
+static inline bool uart_is_writable(uart_inst_t *uart) { (void)uart ; return true ; }
+static inline char uart_getc(uart_inst_t *uart) { (void)uart ; return 0 ; }
+static inline void uart_putc(uart_inst_t *uart, char c) { (void)uart ; putchar(c) ; }
+
+// === spin locks (single threaded on the host) ======================
+typedef volatile uint32_t spin_lock_t ;
+extern spin_lock_t host_spin_locks[32] ;
+static inline spin_lock_t *spin_lock_init(uint n) { host_spin_locks[n] = 0 ; return &host_spin_locks[n] ; }
+static inline void spin_lock_unsafe_blocking(spin_lock_t *lock) { *lock = 1 ; }
+static inline void spin_unlock_unsafe(spin_lock_t *lock) { *lock = 0 ; }
+static inline bool is_spin_locked(spin_lock_t *lock) { return *lock != 0 ; }
+static inline spin_lock_t *spin_lock_instance(uint n) { return &host_spin_locks[n] ; }
+static inline uint32_t spin_lock_blocking(spin_lock_t *lock) { *lock = 1 ; return 0 ; }
+static inline void spin_unlock(spin_lock_t *lock, uint32_t saved_irq) { (void)saved_irq ; *lock = 0 ; }
+
+// === PIO ===========================================================
+typedef struct {
+    volatile uint32_t txf[4] ;
+    volatile uint32_t rxf[4] ;
+} pio_hw_t ;
+typedef pio_hw_t *PIO ;
+extern pio_hw_t host_pio_hw[2] ;
+#define pio0 (&host_pio_hw[0])
+#define pio1 (&host_pio_hw[1])
+
+typedef struct { int unused ; } pio_program_t ;
+typedef struct { int unused ; } pio_sm_config ;
+enum pio_fifo_join { PIO_FIFO_JOIN_NONE = 0, PIO_FIFO_JOIN_TX = 1, PIO_FIFO_JOIN_RX = 2 } ;
+enum pio_interrupt_source { pis_sm0_rx_fifo_not_empty = 0 } ;
+
+static inline uint pio_add_program(PIO pio, const pio_program_t *p) { (void)pio ; (void)p ; return 0 ; }
+static inline int pio_claim_unused_sm(PIO pio, bool required) { (void)pio ; (void)required ; return 0 ; }
+static inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx) { (void)pio ; (void)sm ; (void)is_tx ; return 0 ; }
+static inline void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) { (void)pio ; (void)sm ; (void)enabled ; }
+static inline bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) { (void)pio ; (void)sm ; return true ; }
+static inline uint32_t pio_sm_get(PIO pio, uint sm) { return pio->rxf[sm] ; }
+static inline void pio_set_irq0_source_enabled(PIO pio, enum pio_interrupt_source source, bool enabled) {
+    (void)pio ; (void)source ; (void)enabled ;
+}
+
+// === interrupts (never raised on the host) =========================
+#define PIO1_IRQ_0 9
+typedef void (*irq_handler_t)(void) ;
+static inline void irq_set_exclusive_handler(uint num, irq_handler_t handler) { (void)num ; (void)handler ; }
+static inline void irq_set_enabled(uint num, bool enabled) { (void)num ; (void)enabled ; }
+static inline void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) { pio->txf[sm] = data ; }
+static inline void pio_enable_sm_mask_in_sync(PIO pio, uint32_t mask) { (void)pio ; (void)mask ; }
+
+// === DMA ===========================================================
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 } ;
+#define DREQ_PIO0_TX2 2
+
+typedef struct { uint32_t ctrl ; } dma_channel_config ;
+typedef struct {
+    struct {
+        volatile const void *read_addr ;
+        volatile void *write_addr ;
+        volatile uint32_t transfer_count ;
+    } ch[12] ;
+} dma_hw_t ;
+extern dma_hw_t host_dma_hw ;
+#define dma_hw (&host_dma_hw)
+
+static inline int dma_claim_unused_channel(bool required) {
+    static int next ;
+    (void)required ;
+    return next++ % 12 ;
+}
+static inline dma_channel_config dma_channel_get_default_config(uint ch) {
+    dma_channel_config c = { ch } ;
+    return c ;
+}
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size s) { (void)c ; (void)s ; }
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) { (void)c ; (void)incr ; }
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) { (void)c ; (void)incr ; }
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) { (void)c ; (void)dreq ; }
+static inline void channel_config_set_chain_to(dma_channel_config *c, uint ch) { (void)c ; (void)ch ; }
+static inline void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    (void)c ; (void)write ; (void)size_bits ;
+}
+static inline void dma_channel_configure(uint ch, const dma_channel_config *c, volatile void *write_addr,
+                                         const volatile void *read_addr, uint count, bool trigger) {
+    (void)c ; (void)trigger ;
+    dma_hw->ch[ch].write_addr = write_addr ;
+    dma_hw->ch[ch].read_addr = read_addr ;
+    dma_hw->ch[ch].transfer_count = count ;
+}
+static inline void dma_start_channel_mask(uint32_t mask) { (void)mask ; }
+static inline void dma_channel_set_trans_count(uint ch, uint32_t count, bool trigger) {
+    (void)trigger ;
+    dma_hw->ch[ch].transfer_count = count ;
+}
+static inline void dma_channel_abort(uint ch) { (void)ch ; }
+static inline bool dma_channel_is_busy(uint ch) { (void)ch ; return false ; }
+static inline void dma_channel_wait_for_finish_blocking(uint ch) { (void)ch ; }
+static inline void dma_timer_set_fraction(uint timer, uint16_t numerator, uint16_t denominator) {
+    (void)timer ; (void)numerator ; (void)denominator ;
+}
+
+// === SPI ===========================================================
+typedef struct { volatile uint32_t dr ; } spi_hw_t ;
+typedef spi_hw_t spi_inst_t ;
+extern spi_hw_t host_spi_hw[2] ;
+#define spi0 (&host_spi_hw[0])
+#define spi1 (&host_spi_hw[1])
+static inline spi_hw_t *spi_get_hw(spi_inst_t *spi) { return spi ; }
+static inline uint spi_init(spi_inst_t *spi, uint baudrate) { (void)spi ; return baudrate ; }
+static inline void spi_set_format(spi_inst_t *spi, uint bits, int cpol, int cpha, int order) {
+    (void)spi ; (void)bits ; (void)cpol ; (void)cpha ; (void)order ;
+}
+
+// === multicore FIFO (nothing on the other side) ====================
+static inline bool multicore_fifo_wready(void) { return true ; }
+static inline bool multicore_fifo_rvalid(void) { return false ; }
+static inline void multicore_fifo_push_blocking(uint32_t data) { (void)data ; }
+static inline uint32_t multicore_fifo_pop_blocking(void) { return 0 ; }
+static inline void multicore_fifo_drain(void) { }
+
+// === hardware divider ==============================================
+static inline int64_t div_s64s64(int64_t a, int64_t b) { return a / b ; }
+
+#endif
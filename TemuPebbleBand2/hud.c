@@ -0,0 +1,138 @@
+/**
+ * Allocation-free HUD text fields -- see hud.h
+ */
+#include "hud.h"
+#include "vga16_graphics.h"
+
+/**
+ * @brief Sets up a field; nothing is drawn until the first hud_show_*
+ * @param width Number of character cells the field owns (at most HUD_MAX_CHARS)
+ */
+void hud_init(hud_field *field, short x, short y, unsigned char size, char color, char bg, unsigned char width)
+{
+    field->x = x;
+    field->y = y;
+    field->size = size;
+    field->color = color;
+    field->bg = bg;
+    field->width = (width > HUD_MAX_CHARS) ? HUD_MAX_CHARS : width;
+    hud_invalidate(field);
+}
+
+/**
+ * @brief Forget what is on screen so the next update repaints every cell
+ * Call this after anything else has drawn over the field (e.g. a screen clear).
+ */
+void hud_invalidate(hud_field *field)
+{
+    field->valid = false;
+}
+
+/**
+ * @brief Formats a signed integer in decimal
+ * @param buf Output, at least 12 bytes
+ * @return Number of characters written (not counting the terminator)
+ */
+int hud_format_int(char *buf, int value)
+{
+    char digits[10];
+    int n = 0;
+    int len = 0;
+    unsigned int u = (value < 0) ? -(unsigned int)value : (unsigned int)value;
+
+    do
+    {
+        digits[n++] = '0' + (u % 10);
+        u /= 10;
+    } while (u);
+
+    if (value < 0)
+    {
+        buf[len++] = '-';
+    }
+    while (n)
+    {
+        buf[len++] = digits[--n];
+    }
+    buf[len] = 0;
+    return len;
+}
+
+/**
+ * @brief Formats a fixed-point number stored as value * 10^decimals
+ * e.g. hud_format_fixed(buf, 8750, 2) gives "87.50"
+ * @param decimals Digits after the point, 0-9
+ * @param buf Output, at least 13 bytes
+ * @return Number of characters written (not counting the terminator)
+ */
+int hud_format_fixed(char *buf, int value, int decimals)
+{
+    int len = 0;
+    unsigned int scale = 1;
+    unsigned int u = (value < 0) ? -(unsigned int)value : (unsigned int)value;
+
+    for (int i = 0; i < decimals; i++)
+    {
+        scale *= 10;
+    }
+    if (value < 0)
+    {
+        buf[len++] = '-';
+    }
+    len += hud_format_int(buf + len, u / scale);
+    if (decimals > 0)
+    {
+        unsigned int frac = u % scale;
+        buf[len++] = '.';
+        // fractional digits, most significant first, keeping leading zeros
+        for (int i = decimals - 1; i >= 0; i--)
+        {
+            buf[len + i] = '0' + (frac % 10);
+            frac /= 10;
+        }
+        len += decimals;
+        buf[len] = 0;
+    }
+    return len;
+}
+
+/**
+ * @brief Shows text in the field, padding with spaces to the field width
+ * Only cells whose character differs from what is on screen are redrawn.
+ */
+void hud_show_text(hud_field *field, const char *text)
+{
+    short cell = 6 * field->size;
+    for (int i = 0; i < field->width; i++)
+    {
+        char c = *text ? *text++ : ' ';
+        if (!field->valid || field->shown[i] != c)
+        {
+            drawChar(field->x + i * cell, field->y, c, field->color, field->bg, field->size);
+            field->shown[i] = c;
+        }
+    }
+    field->shown[field->width] = 0;
+    field->valid = true;
+}
+
+/**
+ * @brief Shows an integer, left aligned
+ */
+void hud_show_int(hud_field *field, int value)
+{
+    char buf[HUD_MAX_CHARS + 1];
+    hud_format_int(buf, value);
+    hud_show_text(field, buf);
+}
+
+/**
+ * @brief Shows a fixed-point number stored as value * 10^decimals
+ */
+void hud_show_fixed(hud_field *field, int value, int decimals)
+{
+    char buf[HUD_MAX_CHARS + 2];
+    hud_format_fixed(buf, value, decimals);
+    buf[HUD_MAX_CHARS] = 0; // truncate anything wider than a field
+    hud_show_text(field, buf);
+}
@@ -0,0 +1,38 @@
+/**
+ * Allocation-free HUD text fields.
+ *
+ * A hud_field owns a fixed number of character cells on screen and
+ * remembers what it last drew there. Updating a field formats the new
+ * value into the field's own buffer (no stdio) and redraws only the
+ * cells whose character changed, so a score that goes from 129 to 130
+ * costs two glyphs instead of a full sprintf + writeString.
+ */
+#ifndef HUD_H
+#define HUD_H
+
+#include <stdbool.h>
+
+// Widest field in characters (also the longest formatted number)
+#define HUD_MAX_CHARS 12
+
+typedef struct hud_field
+{
+    short x, y;                        // top-left of the first cell
+    unsigned char size;                // drawChar text size
+    char color, bg;                    // text and background colors (must differ)
+    unsigned char width;               // number of cells owned by the field
+    bool valid;                        // false until the field has been painted
+    char shown[HUD_MAX_CHARS + 1];     // characters currently on screen
+} hud_field;
+
+void hud_init(hud_field *field, short x, short y, unsigned char size, char color, char bg, unsigned char width);
+void hud_invalidate(hud_field *field);
+
+int hud_format_int(char *buf, int value);
+int hud_format_fixed(char *buf, int value, int decimals);
+
+void hud_show_text(hud_field *field, const char *text);
+void hud_show_int(hud_field *field, int value);
+void hud_show_fixed(hud_field *field, int value, int decimals);
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * Timestamped input events from the scanners to the game -- see input_events.h
+ */
+#include <stdio.h>
+#include "input_events.h"
+
+input_ring pianoEvents;
+input_ring keypadEvents;
+
+/**
+ * @brief Takes the oldest event waiting in any ring; consumer side
+ * @return false once every ring is empty
+ */
+bool input_events_next(input_event *ev)
+{
+    const input_event *piano = input_ring_peek(&pianoEvents);
+    const input_event *keypad = input_ring_peek(&keypadEvents);
+    input_ring *from;
+
+    if (piano && (!keypad || (int32_t)(piano->time_us - keypad->time_us) <= 0))
+    {
+        *ev = *piano;
+        from = &pianoEvents;
+    }
+    else if (keypad)
+    {
+        *ev = *keypad;
+        from = &keypadEvents;
+    }
+    else
+    {
+        return false;
+    }
+    input_ring_drop(from);
+    return true;
+}
+
+/**
+ * @brief Prints how many events each ring has dropped
+ */
+void input_events_print(void)
+{
+    printf("input overflows: piano %u, keypad %u\n", pianoEvents.overflows, keypadEvents.overflows);
+}
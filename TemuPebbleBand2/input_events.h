@@ -0,0 +1,93 @@
+/**
+ * Timestamped input events from the scanners to the game.
+ *
+ * Each producer (the piano and keypad scanner threads) has its own
+ * single-producer/single-consumer ring, so pushing never waits and
+ * never takes a lock: the producer only writes head, the consumer only
+ * writes tail. The barriers make the rings safe between cores too.
+ *
+ * The game drains every ring once per tick with input_events_next(),
+ * which merges them oldest first. A push to a full ring is dropped and
+ * counted in that ring's overflows.
+ */
+#ifndef INPUT_EVENTS_H
+#define INPUT_EVENTS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "key_edge.h"
+
+// event sources
+#define INPUT_PIANO 0
+#define INPUT_KEYPAD 1
+
+#define INPUT_RING_SIZE 32 // events per ring, power of two
+
+typedef struct input_event
+{
+    uint8_t source;   // INPUT_PIANO or INPUT_KEYPAD
+    uint8_t key;      // scanner's key number, from 0
+    uint8_t down;     // 1 pressed, 0 released
+    uint32_t time_us; // time_us_32() the change was seen
+} input_event;
+
+typedef struct input_ring
+{
+    input_event events[INPUT_RING_SIZE];
+    volatile uint16_t head;  // next slot to write, producer only
+    volatile uint16_t tail;  // next slot to read, consumer only
+    unsigned int overflows;  // events dropped because the ring was full, producer only
+} input_ring;
+
+extern input_ring pianoEvents;
+extern input_ring keypadEvents;
+
+/**
+ * @brief Queues a scanner edge; producer side
+ * @return false, and the edge is counted as an overflow, if the ring is full
+ */
+static inline bool input_ring_push(input_ring *ring, uint8_t source, const key_edge *edge)
+{
+    uint16_t head = ring->head;
+    uint16_t next = (head + 1) & (INPUT_RING_SIZE - 1);
+    if (next == ring->tail)
+    {
+        ring->overflows++;
+        return false;
+    }
+    ring->events[head].source = source;
+    ring->events[head].key = edge->key;
+    ring->events[head].down = edge->down;
+    ring->events[head].time_us = edge->time_us;
+    __sync_synchronize(); // event written before it is published
+    ring->head = next;
+    return true;
+}
+
+/**
+ * @brief Oldest event in ring without removing it; consumer side
+ * @return NULL if the ring is empty
+ */
+static inline const input_event *input_ring_peek(input_ring *ring)
+{
+    if (ring->tail == ring->head)
+    {
+        return 0;
+    }
+    __sync_synchronize(); // head read before the event it publishes
+    return &ring->events[ring->tail];
+}
+
+/**
+ * @brief Removes the event returned by input_ring_peek(); consumer side
+ */
+static inline void input_ring_drop(input_ring *ring)
+{
+    __sync_synchronize(); // event read before its slot is handed back
+    ring->tail = (ring->tail + 1) & (INPUT_RING_SIZE - 1);
+}
+
+bool input_events_next(input_event *ev);
+void input_events_print(void);
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * Timing judgement for key presses -- see judge.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "judge.h"
+
+// defaults cover the old hit area: +-20 px at 5 px per 30 ms frame
+uint32_t judgeWindowUs[3] = {40000, 80000, 120000};
+judge_session judgeSession;
+
+static const char *gradeNames[JUDGE_GRADES] = {"perfect", "good", "bad", "miss"};
+
+/**
+ * @brief Sets the half-width of each grade's window
+ * Windows are kept nested: a wider grade never ends up narrower than a better one.
+ * Each is clamped to 0..JUDGE_WINDOW_MAX_MS.
+ */
+void judge_set_windows_ms(int perfect, int good, int bad)
+{
+    if (perfect > JUDGE_WINDOW_MAX_MS)
+        perfect = JUDGE_WINDOW_MAX_MS;
+    if (good > JUDGE_WINDOW_MAX_MS)
+        good = JUDGE_WINDOW_MAX_MS;
+    if (bad > JUDGE_WINDOW_MAX_MS)
+        bad = JUDGE_WINDOW_MAX_MS;
+    if (perfect < 0)
+        perfect = 0;
+    if (good < perfect)
+        good = perfect;
+    if (bad < good)
+        bad = good;
+    judgeWindowUs[JUDGE_PERFECT] = perfect * 1000;
+    judgeWindowUs[JUDGE_GOOD] = good * 1000;
+    judgeWindowUs[JUDGE_BAD] = bad * 1000;
+}
+
+/**
+ * @brief Grade for a press error_us after (or before, if negative) the note's scheduled time
+ * @return JUDGE_PERFECT, JUDGE_GOOD, JUDGE_BAD, or JUDGE_NONE outside every window
+ */
+int judge_grade(int32_t error_us)
+{
+    uint32_t e = (error_us < 0) ? -error_us : error_us;
+    for (int g = JUDGE_PERFECT; g <= JUDGE_BAD; g++)
+    {
+        if (e <= judgeWindowUs[g])
+        {
+            return g;
+        }
+    }
+    return JUDGE_NONE;
+}
+
+/**
+ * @brief Adds a result to the session; error_us is ignored for JUDGE_MISS
+ */
+void judge_record(int grade, int32_t error_us)
+{
+    if (grade < 0 || grade >= JUDGE_GRADES)
+    {
+        return;
+    }
+    judgeSession.grades[grade]++;
+    if (grade == JUDGE_MISS)
+    {
+        return;
+    }
+
+    int bin = JUDGE_HIST_BINS / 2;
+    bin += (error_us + ((error_us < 0) ? -JUDGE_HIST_BIN_US / 2 : JUDGE_HIST_BIN_US / 2)) / JUDGE_HIST_BIN_US;
+    if (bin < 0)
+        bin = 0;
+    if (bin >= JUDGE_HIST_BINS)
+        bin = JUDGE_HIST_BINS - 1;
+    judgeSession.histogram[bin]++;
+
+    if (judgeSession.judged == 0 || error_us < judgeSession.earliest)
+        judgeSession.earliest = error_us;
+    if (judgeSession.judged == 0 || error_us > judgeSession.latest)
+        judgeSession.latest = error_us;
+    judgeSession.errorSum += error_us;
+    judgeSession.absErrorSum += (error_us < 0) ? -error_us : error_us;
+    judgeSession.judged++;
+}
+
+/**
+ * @brief Starts a new session (clears counts and the histogram)
+ */
+void judge_reset_session(void)
+{
+    memset(&judgeSession, 0, sizeof(judgeSession));
+}
+
+/**
+ * @brief Prints the session's grades and timing histogram over stdio
+ */
+void judge_print_session(void)
+{
+    judge_session *s = &judgeSession;
+    printf("judgement windows: perfect %lu ms, good %lu ms, bad %lu ms\n",
+           (unsigned long)judgeWindowUs[JUDGE_PERFECT] / 1000, (unsigned long)judgeWindowUs[JUDGE_GOOD] / 1000,
+           (unsigned long)judgeWindowUs[JUDGE_BAD] / 1000);
+    for (int g = 0; g < JUDGE_GRADES; g++)
+    {
+        printf("%s %u%s", gradeNames[g], s->grades[g], (g < JUDGE_GRADES - 1) ? ", " : "\n");
+    }
+    if (s->judged == 0)
+    {
+        return;
+    }
+    printf("timing error: mean %+ld us, mean abs %lu us, earliest %+ld us, latest %+ld us\n",
+           (long)(s->errorSum / (int64_t)s->judged), (unsigned long)(s->absErrorSum / s->judged),
+           (long)s->earliest, (long)s->latest);
+
+    unsigned int peak = 1;
+    for (int b = 0; b < JUDGE_HIST_BINS; b++)
+    {
+        if (s->histogram[b] > peak)
+            peak = s->histogram[b];
+    }
+    for (int b = 0; b < JUDGE_HIST_BINS; b++)
+    {
+        int centre_ms = (b - JUDGE_HIST_BINS / 2) * (JUDGE_HIST_BIN_US / 1000);
+        int bar = s->histogram[b] * 40 / peak;
+        printf("%+5d ms %4u |", centre_ms, s->histogram[b]);
+        for (int k = 0; k < bar; k++)
+            putchar('#');
+        putchar('\n');
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ * Timing judgement for key presses.
+ *
+ * A press is graded by how far its timestamp is from the scheduled hit
+ * time of the note it is judged against, not by where the note happens
+ * to be drawn, so frame rate and scan rate do not change the result.
+ * Each grade has a window in microseconds (set in milliseconds); a
+ * press outside the widest window is not a judgement at all.
+ *
+ * Every judged press also goes into the session's timing histogram,
+ * which is cleared by judge_reset_session() when a game ends.
+ */
+#ifndef JUDGE_H
+#define JUDGE_H
+
+#include <stdint.h>
+
+// grades, best first
+#define JUDGE_PERFECT 0
+#define JUDGE_GOOD 1
+#define JUDGE_BAD 2
+#define JUDGE_MISS 3 // note left the screen unplayed
+#define JUDGE_GRADES 4
+#define JUDGE_NONE -1 // press too far from any note to count
+
+// histogram of timing errors (press time - scheduled time)
+#define JUDGE_HIST_BINS 25        // odd, so the middle bin is centred on 0
+#define JUDGE_HIST_BIN_US 10000   // 10 ms per bin; the end bins also hold everything beyond them
+
+typedef struct judge_session
+{
+    unsigned int grades[JUDGE_GRADES];        // count per grade
+    unsigned int histogram[JUDGE_HIST_BINS];  // judged presses by timing error
+    int64_t errorSum;                         // for the mean (early < 0 < late)
+    uint64_t absErrorSum;                     // for the mean absolute error
+    int32_t earliest, latest;                 // extreme errors this session
+    unsigned int judged;                      // presses that got a grade
+} judge_session;
+
+#define JUDGE_WINDOW_MAX_MS 1000 // widest window judge_set_windows_ms() allows
+
+extern uint32_t judgeWindowUs[3]; // PERFECT, GOOD, BAD half-widths
+extern judge_session judgeSession;
+
+void judge_set_windows_ms(int perfect, int good, int bad);
+int judge_grade(int32_t error_us);
+void judge_record(int grade, int32_t error_us);
+void judge_reset_session(void);
+void judge_print_session(void);
+
+#endif
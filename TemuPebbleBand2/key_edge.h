@@ -0,0 +1,17 @@
+/**
+ * A key changing state, as reported by the input scanners
+ * (piano_scan.h, keypad_scan.h).
+ */
+#ifndef KEY_EDGE_H
+#define KEY_EDGE_H
+
+#include <stdint.h>
+
+typedef struct key_edge
+{
+    uint8_t key;      // scanner's key number, from 0
+    uint8_t down;     // 1 pressed, 0 released
+    uint32_t time_us; // time_us_32() of the scan that saw the change
+} key_edge;
+
+#endif
@@ -0,0 +1,135 @@
+/**
+ * 4x3 keypad matrix scanner -- see keypad_scan.h
+ */
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/irq.h"
+#include "keypad_scan.pio.h"
+#include "keypad_scan.h"
+
+debouncer keypadDebounce;
+unsigned int keypadQueueOverruns;
+
+// row bit in the low nibble, column bit in the high one, per key
+static const unsigned char keycodes[KEYPAD_KEYS] = {0x28, 0x11, 0x21, 0x41, 0x12, 0x22, 0x42, 0x14, 0x24, 0x44, 0x18, 0x48};
+static uint16_t keyBit[KEYPAD_KEYS]; // each key's bit in the scanned matrix
+
+static PIO keypadPio;
+static uint keypadSm;
+static void (*onChange)(void); // called by the interrupt after queueing
+
+// changes queued by the interrupt, drained by keypad_scan_drain()
+static volatile uint16_t queueMatrix[KEYPAD_QUEUE];
+static volatile uint32_t queueTime[KEYPAD_QUEUE];
+static volatile uint8_t queueHead; // written by the interrupt only
+static volatile uint8_t queueTail; // written by the drain only
+static volatile uint16_t latestMatrix; // newest matrix, even if the queue was full
+
+static uint16_t lastMatrix; // matrix last fed to the debouncer
+
+/**
+ * @brief RX FIFO not empty: timestamp and queue every matrix the scanner pushed
+ */
+static void keypad_scan_irq(void)
+{
+    uint32_t now = time_us_32();
+    while (!pio_sm_is_rx_fifo_empty(keypadPio, keypadSm))
+    {
+        uint16_t matrix = pio_sm_get(keypadPio, keypadSm);
+        uint8_t next = (queueHead + 1) & (KEYPAD_QUEUE - 1);
+        latestMatrix = matrix;
+        if (next == queueTail)
+        {
+            keypadQueueOverruns++;
+            continue;
+        }
+        queueMatrix[queueHead] = matrix;
+        queueTime[queueHead] = now;
+        queueHead = next;
+    }
+    if (onChange)
+    {
+        onChange();
+    }
+}
+
+/**
+ * @brief Starts the scanning state machine on pio1 and its interrupt
+ * @param on_change called from the interrupt whenever a change was seen, or NULL
+ */
+void keypad_scan_init(void (*on_change)(void))
+{
+    keypadPio = pio1;
+    onChange = on_change;
+
+    // matrix bit of each key: row r's columns land in bits 3*(3-r) .. 3*(3-r)+2
+    for (int i = 0; i < KEYPAD_KEYS; i++)
+    {
+        int row = __builtin_ctz(keycodes[i] & 0x0F);
+        int col = __builtin_ctz(keycodes[i] >> 4);
+        keyBit[i] = 1u << (3 * (3 - row) + col);
+    }
+
+    // Turn on pulldown resistors for column pins
+    for (int i = 4; i < 7; i++)
+    {
+        gpio_init(BASE_KEYPAD_PIN + i);
+        gpio_set_dir(BASE_KEYPAD_PIN + i, GPIO_IN);
+        gpio_pull_down(BASE_KEYPAD_PIN + i);
+    }
+
+    uint offset = pio_add_program(keypadPio, &keypad_scan_program);
+    keypadSm = pio_claim_unused_sm(keypadPio, true);
+    keypad_scan_program_init(keypadPio, keypadSm, offset, BASE_KEYPAD_PIN, BASE_KEYPAD_PIN + 4);
+
+    queueHead = 0;
+    queueTail = 0;
+    latestMatrix = 0;
+    lastMatrix = 0;
+    debounce_init(&keypadDebounce, KEYPAD_KEYS, KEYPAD_SETTLE_US, DEBOUNCE_EAGER);
+
+    pio_set_irq0_source_enabled(keypadPio, pis_sm0_rx_fifo_not_empty + keypadSm, true);
+    irq_set_exclusive_handler(PIO1_IRQ_0, keypad_scan_irq);
+    irq_set_enabled(PIO1_IRQ_0, true);
+    pio_sm_set_enabled(keypadPio, keypadSm, true);
+}
+
+// Feeds the debouncer the keys held in matrix as seen at time t, appending edges
+static int apply_matrix(uint16_t matrix, uint32_t t, key_edge *edges, int n)
+{
+    uint16_t keys = 0;
+    for (int k = 0; k < KEYPAD_KEYS; k++)
+    {
+        if (matrix & keyBit[k])
+            keys |= 1u << k;
+    }
+    lastMatrix = matrix;
+    return debounce_update(&keypadDebounce, keys, t, edges, n);
+}
+
+/**
+ * @brief Converts the queued matrix changes into key edges
+ * Stops early, leaving the rest for the next call, if edges fills up.
+ * @return number of edges written, oldest first
+ */
+int keypad_scan_drain(key_edge *edges, int max)
+{
+    int n = 0;
+    while (queueTail != queueHead)
+    {
+        if (n + KEYPAD_KEYS > max)
+        {
+            return n; // no room for every edge this change could hold
+        }
+        n = apply_matrix(queueMatrix[queueTail], queueTime[queueTail], edges, n);
+        queueTail = (queueTail + 1) & (KEYPAD_QUEUE - 1);
+    }
+
+    // changes only arrive when the matrix moves, so settling keys are finished here,
+    // as is a change lost to a full queue
+    if ((keypadDebounce.settling || latestMatrix != lastMatrix) && n + KEYPAD_KEYS <= max)
+    {
+        n = apply_matrix(latestMatrix, time_us_32(), edges, n);
+    }
+    return n;
+}
@@ -0,0 +1,34 @@
+/**
+ * 4x3 keypad matrix scanner.
+ *
+ * A PIO state machine on pio1 (keypad_scan.pio) strobes the rows and
+ * reads the columns continuously, and pushes the matrix only when it
+ * changes. The RX FIFO interrupt timestamps each change and queues it,
+ * then calls the on_change hook given to keypad_scan_init(), so the
+ * drain can be woken rather than polled; nothing runs on the CPU while
+ * the keypad is idle.
+ *
+ * keypad_scan_drain() feeds queued changes through keypadDebounce
+ * (debounce.h) and returns edges for every key, so several keys can be
+ * held at once.
+ */
+#ifndef KEYPAD_SCAN_H
+#define KEYPAD_SCAN_H
+
+#include <stdint.h>
+#include "key_edge.h"
+#include "debounce.h"
+
+// Keypad pin configurations
+#define BASE_KEYPAD_PIN 9 // 4 row pins from here, then 3 column pins
+#define KEYPAD_KEYS 12
+#define KEYPAD_QUEUE 16             // changes buffered between drains, power of two
+#define KEYPAD_SETTLE_US 5000       // default debounce settle time
+
+extern debouncer keypadDebounce;         // debounced keys, settle time and bounce counts
+extern unsigned int keypadQueueOverruns; // changes dropped because the queue was full
+
+void keypad_scan_init(void (*on_change)(void));
+int keypad_scan_drain(key_edge *edges, int max);
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * Pooled storage for the falling notes -- see note_pool.h
+ */
+#include "note_pool.h"
+
+note_pool notePool;
+
+/**
+ * @brief Drops every note in every lane
+ * Constant time: lane lists from an older generation read as empty and
+ * the allocator starts handing out ids from 0 again.
+ */
+void note_pool_reset(void)
+{
+    notePool.generation++;
+    notePool.freeCount = 0;
+    notePool.fresh = 0;
+}
+
+/**
+ * @brief Adds a note to the end of a lane
+ * @param y Top edge of the note
+ * @param height Height in pixels
+ * @param hitTime time_us_32() at which the note should be hit
+ * @return The new note's id, or -1 if the lane or the pool is full
+ */
+int note_pool_spawn(int lane, fix15 y, int height, int color, bool sustain, uint32_t hitTime)
+{
+    int count = note_lane_count(lane);
+    note_id n;
+
+    if (count >= NOTE_LANE_CAPACITY)
+    {
+        return -1;
+    }
+    if (count == 0)
+    {
+        notePool.laneHead[lane] = 0; // also adopts a lane left over from an older generation
+        notePool.laneJudge[lane] = 0;
+    }
+    if (notePool.freeCount > 0)
+    {
+        n = notePool.freeList[--notePool.freeCount];
+    }
+    else if (notePool.fresh < NOTE_POOL_CAPACITY)
+    {
+        n = notePool.fresh++;
+    }
+    else
+    {
+        return -1;
+    }
+
+    notePool.y[n] = y;
+    notePool.height[n] = height;
+    notePool.step[n] = 0;
+    notePool.color[n] = color;
+    notePool.flags[n] = sustain ? NOTE_SUSTAIN : 0;
+    notePool.hitTime[n] = hitTime;
+
+    notePool.lane[lane][(notePool.laneHead[lane] + count) & (NOTE_LANE_CAPACITY - 1)] = n;
+    notePool.laneCount[lane] = count + 1;
+    notePool.laneGeneration[lane] = notePool.generation;
+    return n;
+}
+
+/**
+ * @brief Removes the note in the slot-th oldest slot of a lane
+ * Everything else keeps its order. Removing the oldest note also drops
+ * any tombstones behind it, which renumbers the remaining slots, so
+ * when despawning while iterating, walk the lane from the back. The
+ * judge cursor stays on the same note, or on the next slot if this was it.
+ */
+void note_pool_despawn(int lane, int slot)
+{
+    const int mask = NOTE_LANE_CAPACITY - 1;
+    note_id *ring = notePool.lane[lane];
+    int head = notePool.laneHead[lane];
+    int count = notePool.laneCount[lane];
+
+    notePool.freeList[notePool.freeCount++] = ring[(head + slot) & mask];
+    ring[(head + slot) & mask] = NOTE_NONE;
+    while (count > 0 && ring[(head + count - 1) & mask] == NOTE_NONE)
+    {
+        count--; // trailing tombstones just shorten the lane
+    }
+    int judge = notePool.laneJudge[lane];
+    while (count > 0 && ring[head] == NOTE_NONE)
+    {
+        head = (head + 1) & mask;
+        count--;
+        judge -= (judge > 0);
+    }
+    notePool.laneHead[lane] = head;
+    notePool.laneCount[lane] = count;
+    notePool.laneJudge[lane] = (judge < count) ? judge : count;
+}
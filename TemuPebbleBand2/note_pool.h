@@ -0,0 +1,120 @@
+/**
+ * Pooled storage for the falling notes.
+ *
+ * Note fields live in parallel arrays indexed by a one-byte note id, so
+ * the update and draw loops only pull in the fields they touch. Each
+ * lane keeps a ring buffer of the ids falling in it, in spawn order --
+ * which is also hit order, since every note enters with its bottom
+ * edge at the top of the screen and all notes fall at the same speed.
+ * A note removed from the middle of a lane leaves a NOTE_NONE
+ * tombstone so the order survives; tombstones are dropped when they
+ * reach the head, so the head slot always holds a live note.
+ *
+ * Each lane also keeps a judge cursor: the slot of the next note a press
+ * is judged against. The game moves it past notes that were hit or can
+ * no longer be, so judging a press looks at one slot.
+ *
+ * Ids come from a bump allocator backed by a free stack, and each lane
+ * is tagged with the pool generation, so note_pool_reset() is a single
+ * increment however many notes were live.
+ *
+ * Everything here is touched from core 0 protothreads only.
+ */
+#ifndef NOTE_POOL_H
+#define NOTE_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fix15.h"
+
+#ifndef NOTE_POOL_CAPACITY
+#define NOTE_POOL_CAPACITY 128 // notes alive at once across all lanes (at most 255)
+#endif
+#ifndef NOTE_LANE_CAPACITY
+#define NOTE_LANE_CAPACITY 32 // notes alive at once in a single lane (a power of two)
+#endif
+#define NOTE_LANES 13
+
+#if NOTE_POOL_CAPACITY > 255
+#error "NOTE_POOL_CAPACITY must fit in a note_id (255 is NOTE_NONE)"
+#endif
+#if (NOTE_LANE_CAPACITY & (NOTE_LANE_CAPACITY - 1)) != 0 || NOTE_LANE_CAPACITY > 128
+#error "NOTE_LANE_CAPACITY must be a power of two, at most 128"
+#endif
+
+// note flags
+#define NOTE_HIT 0x01     // held down in the hit area -- shrinks instead of falling past
+#define NOTE_SUSTAIN 0x02 // long note
+#define NOTE_JUDGED 0x04  // a press was judged against it: never judged again, never a miss
+
+typedef unsigned char note_id;
+#define NOTE_NONE 0xFF // tombstone / no note
+
+typedef struct note_pool
+{
+    fix15 y[NOTE_POOL_CAPACITY];             // top edge of the note, sub-pixel
+    short height[NOTE_POOL_CAPACITY];        // height in pixels -- shrinks as a sustain is played
+    unsigned char step[NOTE_POOL_CAPACITY];  // whole pixels moved on the last update -- rows to redraw
+    unsigned char color[NOTE_POOL_CAPACITY]; // 0-15
+    unsigned char flags[NOTE_POOL_CAPACITY]; // NOTE_HIT | NOTE_SUSTAIN | NOTE_JUDGED
+    uint32_t hitTime[NOTE_POOL_CAPACITY];    // time_us_32() at which the note should be hit
+
+    note_id lane[NOTE_LANES][NOTE_LANE_CAPACITY]; // ring of ids falling in each lane, oldest first
+    unsigned char laneHead[NOTE_LANES];           // ring index of the oldest slot
+    unsigned char laneCount[NOTE_LANES];          // slots in use, tombstones included -- only valid while laneGeneration matches
+    unsigned char laneJudge[NOTE_LANES];          // slot of the next note to judge; laneCount when there is none
+    unsigned int laneGeneration[NOTE_LANES];
+
+    note_id freeList[NOTE_POOL_CAPACITY]; // despawned ids, reused first
+    unsigned char freeCount;
+    unsigned short fresh;    // ids at or above this have not been handed out this generation
+    unsigned int generation; // bumped by note_pool_reset
+} note_pool;
+
+extern note_pool notePool;
+
+void note_pool_reset(void);
+int note_pool_spawn(int lane, fix15 y, int height, int color, bool sustain, uint32_t hitTime);
+void note_pool_despawn(int lane, int slot);
+
+/**
+ * @brief Number of slots in use in a lane, oldest (slot 0) to newest
+ * Some of them may be tombstones; 0 means the lane is empty.
+ */
+static inline int note_lane_count(int lane)
+{
+    return (notePool.laneGeneration[lane] == notePool.generation) ? notePool.laneCount[lane] : 0;
+}
+
+/** @brief Id in the slot-th oldest slot of a lane (slot < note_lane_count(lane)), or NOTE_NONE */
+static inline note_id note_lane_id(int lane, int slot)
+{
+    return notePool.lane[lane][(notePool.laneHead[lane] + slot) & (NOTE_LANE_CAPACITY - 1)];
+}
+
+/** @brief The note at a lane's judge cursor, or NOTE_NONE if the cursor is on a tombstone or past the end */
+static inline note_id note_lane_judged(int lane)
+{
+    return (notePool.laneJudge[lane] < note_lane_count(lane)) ? note_lane_id(lane, notePool.laneJudge[lane])
+                                                               : NOTE_NONE;
+}
+
+/** @brief true once a lane's judge cursor has passed its newest note */
+static inline bool note_lane_judged_all(int lane)
+{
+    return notePool.laneJudge[lane] >= note_lane_count(lane);
+}
+
+/** @brief Moves a lane's judge cursor to the next slot */
+static inline void note_lane_judge_next(int lane)
+{
+    notePool.laneJudge[lane]++;
+}
+
+/** @brief The note due to be hit first in a lane, or NOTE_NONE */
+static inline note_id note_lane_head(int lane)
+{
+    return note_lane_count(lane) ? notePool.lane[lane][notePool.laneHead[lane]] : NOTE_NONE;
+}
+
+#endif
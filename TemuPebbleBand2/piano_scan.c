@@ -0,0 +1,129 @@
+/**
+ * Piano keyboard scanner -- see piano_scan.h
+ */
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "piano_scan.pio.h"
+#include "piano_scan.h"
+
+#define SCAN_TRANSFERS 0xFFFFFFFFu // DMA count per arming: about 5 days of scans
+
+debouncer pianoDebounce;
+unsigned int pianoScanOverruns;
+
+// written by DMA; aligned to its size for the DMA ring wrap
+static uint16_t scanRing[PIANO_SCAN_RING] __attribute__((aligned(PIANO_SCAN_RING * sizeof(uint16_t))));
+static int scanChan;
+static uint32_t scanBase;  // scans completed by earlier armings of the channel
+static uint32_t scanRead;  // scans already drained
+static uint16_t lastRaw;   // last raw bitmap seen, so unchanged scans cost one compare
+
+// MUX_1 channel -> key (channels 6 and 7 are wired the other way round)
+static const uint8_t mux1Key[8] = {0, 1, 2, 3, 4, 5, 7, 6};
+
+/**
+ * @brief Raw scan bitmap (channel c in bits 2c, 2c+1) to key bitmap
+ */
+static uint16_t raw_to_keys(uint16_t raw)
+{
+    uint16_t keys = 0;
+    for (int c = 0; c < 8; c++)
+    {
+        if ((raw >> (2 * c)) & 1)
+            keys |= 1u << mux1Key[c];
+        if (c < MUX_2_CHECK && ((raw >> (2 * c + 1)) & 1))
+            keys |= 1u << (c + 8);
+    }
+    return keys;
+}
+
+/**
+ * @brief Starts the scanning state machine on pio1 and its DMA channel
+ */
+void piano_scan_init(void)
+{
+    PIO pio = pio1;
+
+    gpio_init(MUX_1);
+    gpio_set_dir(MUX_1, GPIO_IN);
+    gpio_pull_down(MUX_1);
+
+    gpio_init(MUX_2);
+    gpio_set_dir(MUX_2, GPIO_IN);
+    gpio_pull_down(MUX_2);
+
+    uint offset = pio_add_program(pio, &piano_scan_program);
+    uint sm = pio_claim_unused_sm(pio, true);
+    piano_scan_program_init(pio, sm, offset, MUX_SEL0, MUX_1);
+
+    // one 16-bit bitmap per scan from the RX FIFO into the ring
+    scanChan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(scanChan); // default configs
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);          // 16-bit txfers
+    channel_config_set_read_increment(&c, false);                    // always the FIFO
+    channel_config_set_write_increment(&c, true);                    // walk the ring
+    channel_config_set_ring(&c, true, __builtin_ctz(sizeof(scanRing))); // wrap the write address
+    channel_config_set_dreq(&c, pio_get_dreq(pio, sm, false));       // paced by the RX FIFO
+
+    dma_channel_configure(
+        scanChan,         // Channel to be configured
+        &c,               // The configuration we just created
+        scanRing,         // write address (sample ring)
+        &pio->rxf[sm],    // read address (scanner RX FIFO)
+        SCAN_TRANSFERS,   // Number of transfers
+        true              // Start immediately
+    );
+
+    scanBase = 0;
+    scanRead = 0;
+    lastRaw = 0;
+    debounce_init(&pianoDebounce, PIANO_KEYS, PIANO_SETTLE_US, DEBOUNCE_EAGER);
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+/**
+ * @brief Converts the scans since the last call into key edges
+ * Stops early, leaving the rest for the next call, if edges fills up.
+ * @return number of edges written, oldest first
+ */
+int piano_scan_drain(key_edge *edges, int max)
+{
+    uint32_t now = time_us_32();
+    uint32_t remaining = dma_hw->ch[scanChan].transfer_count;
+    uint32_t written = scanBase + (SCAN_TRANSFERS - remaining);
+    int n = 0;
+
+    // re-arm once the count runs out; the write address carries on round the ring
+    if (remaining == 0 && !dma_channel_is_busy(scanChan))
+    {
+        scanBase += SCAN_TRANSFERS;
+        dma_channel_set_trans_count(scanChan, SCAN_TRANSFERS, true);
+    }
+
+    // too late: the oldest unread scans have been overwritten, keep the newest half
+    if (written - scanRead > PIANO_SCAN_RING - PIANO_SCAN_RING / 8)
+    {
+        pianoScanOverruns++;
+        scanRead = written - PIANO_SCAN_RING / 2;
+    }
+
+    for (; scanRead != written; scanRead++)
+    {
+        uint16_t raw = scanRing[scanRead & (PIANO_SCAN_RING - 1)];
+        if (raw == lastRaw && !pianoDebounce.settling)
+        {
+            continue;
+        }
+        if (n + PIANO_KEYS > max)
+        {
+            break; // no room for every edge this scan could hold
+        }
+        lastRaw = raw;
+
+        // newest scan finished within the last period, older ones a period apart
+        uint32_t t = now - (written - 1 - scanRead) * PIANO_SCAN_PERIOD_US;
+        n = debounce_update(&pianoDebounce, raw_to_keys(raw), t, edges, n);
+    }
+    return n;
+}
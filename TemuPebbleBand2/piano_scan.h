@@ -0,0 +1,40 @@
+/**
+ * Piano keyboard scanner.
+ *
+ * The 13 keys sit behind two 8:1 multiplexers. A PIO state machine on
+ * pio1 (piano_scan.pio) steps the select lines and samples both mux
+ * outputs continuously, 10000 scans a second, and DMA copies every
+ * scan's bitmap into a ring in RAM. No CPU time is spent scanning.
+ *
+ * piano_scan_drain() walks the samples written since the last call,
+ * feeds key changes through pianoDebounce (debounce.h) and returns the
+ * edges stamped with the time of the scan that saw them, so a press is
+ * timed to within one scan period however late the draining thread runs.
+ */
+#ifndef PIANO_SCAN_H
+#define PIANO_SCAN_H
+
+#include <stdint.h>
+#include "key_edge.h"
+#include "debounce.h"
+
+// Mux Pins
+#define MUX_SEL0 2 // MUX_SEL0..MUX_SEL2 must be consecutive
+#define MUX_SEL1 3
+#define MUX_SEL2 4
+#define MUX_1 27 // MUX_1, MUX_2 must be consecutive
+#define MUX_2 28
+#define MUX_2_CHECK 5 // channels of the second mux that have keys on them
+
+#define PIANO_KEYS 13
+#define PIANO_SCAN_PERIOD_US 100 // one scan of all 8 channels (see piano_scan.pio)
+#define PIANO_SCAN_RING 1024     // samples, power of two: 102 ms of history
+#define PIANO_SETTLE_US 5000     // default debounce settle time
+
+extern debouncer pianoDebounce;         // debounced keys, settle time and bounce counts
+extern unsigned int pianoScanOverruns;  // drains that came too late and lost samples
+
+void piano_scan_init(void);
+int piano_scan_drain(key_edge *edges, int max);
+
+#endif
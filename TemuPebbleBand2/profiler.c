@@ -0,0 +1,79 @@
+/**
+ * Per-stage frame profiler -- see profiler.h
+ */
+#include <stdio.h>
+#include "profiler.h"
+
+prof_stage profStages[PROF_STAGES];
+
+const char *const profStageNames[PROF_STAGES] = {
+    "erase", "update", "draw", "hitline", "hud",
+    "r_erase", "r_notes", "r_hitline", "r_hud", "r_other",
+};
+
+/**
+ * @brief Ends the frame for stages first..last: each one's total goes into its ring
+ */
+void prof_commit(int first, int last)
+{
+    for (int i = first; i <= last; i++)
+    {
+        prof_stage *s = &profStages[i];
+        s->samples[s->head] = s->pending;
+        s->head = (s->head + 1) & (PROF_RING - 1);
+        if (s->count < PROF_RING)
+        {
+            s->count++;
+        }
+        s->pending = 0;
+    }
+}
+
+/**
+ * @brief Per-frame min, average and max of a stage over the frames in its ring, in microseconds
+ */
+void prof_stats(int stage, uint32_t *min, uint32_t *avg, uint32_t *max)
+{
+    const prof_stage *s = &profStages[stage];
+    uint32_t lo = 0xFFFFFFFFu, hi = 0, sum = 0;
+    int n = s->count;
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t t = s->samples[i];
+        lo = (t < lo) ? t : lo;
+        hi = (t > hi) ? t : hi;
+        sum += t;
+    }
+    *min = n ? lo : 0;
+    *avg = n ? sum / n : 0;
+    *max = hi;
+}
+
+/**
+ * @brief Forgets the samples of stages first..last
+ * Called from the core that times them, like prof_commit().
+ */
+void prof_reset(int first, int last)
+{
+    for (int i = first; i <= last; i++)
+    {
+        profStages[i].pending = 0;
+        profStages[i].head = 0;
+        profStages[i].count = 0;
+    }
+}
+
+/**
+ * @brief Prints one CSV row per stage: name, frames sampled and min/avg/max microseconds
+ */
+void prof_dump_csv(void)
+{
+    printf("stage,frames,min_us,avg_us,max_us\n");
+    for (int i = 0; i < PROF_STAGES; i++)
+    {
+        uint32_t lo, avg, hi;
+        prof_stats(i, &lo, &avg, &hi);
+        printf("%s,%u,%lu,%lu,%lu\n", profStageNames[i], profStages[i].count, (unsigned long)lo,
+               (unsigned long)avg, (unsigned long)hi);
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * Per-stage frame profiler.
+ *
+ * Code under test is wrapped in a scope: prof_begin() reads time_us_32()
+ * and prof_end() adds the time since to the stage's total for the
+ * current frame. A stage can be entered any number of times per frame.
+ * prof_commit() ends the frame for a range of stages, pushing each
+ * total into that stage's ring of the last PROF_RING frames, from which
+ * prof_stats() gives min/avg/max.
+ *
+ * The game stages are timed on the game core and committed once per
+ * tick; the render stages are timed by the renderer and committed when
+ * it reaches the end of a frame. Each stage is written by one core only,
+ * so each core also resets its own stages with prof_reset().
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+
+#define PROF_RING 64 // frames kept per stage, power of two
+
+// stages, game core first
+enum prof_stage_id
+{
+    PROF_ERASE,     // queueing the erase of the notes' old tops (draw_notes(1))
+    PROF_UPDATE,    // update_notes()
+    PROF_DRAW,      // queueing the notes' new bottoms (draw_notes(0))
+    PROF_HITLINE,   // draw_hitLine()
+    PROF_HUD,       // queueing the HUD values
+    PROF_R_ERASE,   // renderer: note strips erased
+    PROF_R_NOTES,   // renderer: note strips drawn
+    PROF_R_HITLINE, // renderer: hit line
+    PROF_R_HUD,     // renderer: HUD digits
+    PROF_R_OTHER,   // renderer: everything else (keys, banners, hearts, this overlay)
+    PROF_STAGES
+};
+
+#define PROF_GAME_FIRST PROF_ERASE
+#define PROF_GAME_LAST PROF_HUD
+#define PROF_RENDER_FIRST PROF_R_ERASE
+#define PROF_RENDER_LAST PROF_R_OTHER
+
+typedef struct prof_stage
+{
+    uint32_t pending;            // time in the stage so far this frame
+    uint32_t samples[PROF_RING]; // per-frame totals, oldest overwritten
+    uint16_t head;               // next sample to write
+    uint16_t count;              // samples held, up to PROF_RING
+} prof_stage;
+
+extern prof_stage profStages[PROF_STAGES];
+extern const char *const profStageNames[PROF_STAGES];
+
+static inline uint32_t prof_begin(void)
+{
+    return time_us_32();
+}
+
+static inline void prof_end(int stage, uint32_t start)
+{
+    profStages[stage].pending += time_us_32() - start;
+}
+
+void prof_commit(int first, int last);
+void prof_stats(int stage, uint32_t *min, uint32_t *avg, uint32_t *max);
+void prof_reset(int first, int last);
+void prof_dump_csv(void);
+
+#endif
@@ -562,12 +562,44 @@ struct pt_sem {
 // max time of about 300,000 years
 // uint64_t time_us_64 (void)
 
+// wake-up lateness (time past the deadline) goes into the
+// thread's scheduler stats, see pt_thread_stats below;
+// pt_wait_request() tells the deadline scheduler when to call back,
+// since PT_YIELD_UNTIL returns once without testing its condition
 #define PT_YIELD_usec(delay_time)  \
     do { static uint64_t time_thread ;\
     time_thread = time_us_64() + (uint64_t)delay_time ; \
-    PT_YIELD_UNTIL(pt, (time_us_64() >= time_thread)); \
+    pt_wait_request(0, time_thread); \
+    PT_YIELD_UNTIL(pt, pt_wait_until(time_thread)); \
+    pt_record_wakeup(time_thread); \
     } while(0);
 
+// macro to make a thread pause until an absolute time_us_64() deadline
+#define PT_YIELD_UNTIL_usec(wake_time)  \
+    do { static uint64_t time_thread ;\
+    time_thread = (wake_time) ; \
+    pt_wait_request(0, time_thread); \
+    PT_YIELD_UNTIL(pt, pt_wait_until(time_thread)); \
+    pt_record_wakeup(time_thread); \
+    } while(0);
+
+// macros to make a thread wait for an event signalled with
+// pt_event_signal(), see PT_EVENT below; the bits of mask that were
+// set are cleared and left in pt_event_taken (0 on a timeout)
+#define PT_YIELD_EVENT_UNTIL_usec(mask, wake_time)  \
+    do { static uint64_t time_thread ;\
+    time_thread = (wake_time) ; \
+    pt_wait_request((mask), time_thread); \
+    PT_YIELD_UNTIL(pt, pt_wait_event((mask), time_thread)); \
+    } while(0);
+
+// wait for any event in mask, or delay_time usec at most
+#define PT_YIELD_EVENT_usec(mask, delay_time)  \
+    PT_YIELD_EVENT_UNTIL_usec(mask, time_us_64() + (uint64_t)(delay_time))
+
+// wait for any event in mask, however long it takes
+#define PT_YIELD_EVENT(mask) PT_YIELD_EVENT_UNTIL_usec(mask, PT_NO_WAKE)
+
 // macro to return system time
 #define PT_GET_TIME_usec() (time_us_64())
 
@@ -630,7 +662,8 @@ spin_lock_t * lock_lock ;
 // general pattern will be to lock lock_lock
 // do specific lock operation (on another spin_lock)
 // unlock lock_lock
-// NOTE vaild lock_num are from 26-31 total of SIX hardware locks!
+// NOTE vaild lock_num are from 27-31 total of FIVE hardware locks!
+// (26 is PT_EVENT_LOCK, below)
 
 #define PT_LOCK_INIT(s,lock_num,lock_state) do{ \
   lock_lock = spin_lock_init(24); \
@@ -699,6 +732,7 @@ struct ptx {
 	struct pt pt;              // thread context
 	int num;                    // thread number
 	char (*pf)(struct pt *pt); // pointer to thread function
+	const char *name;          // for the stats, set by pt_add_thread
 };
 
 // === extended structure for scheduler ===============
@@ -780,9 +814,153 @@ SOFTWARE.
 // choose schedule method
 #define SCHED_ROUND_ROBIN 0
 #define SCHED_PRIORITY    1
+#define SCHED_DEADLINE    2
 // default is round robin
 int pt_sched_method = SCHED_ROUND_ROBIN ;
 
+// =========================================
+// SCHED_DEADLINE: threads sleeping in PT_YIELD_usec or
+// PT_YIELD_UNTIL_usec sit in a min-heap ordered by wake time and
+// are only called once due. Threads waiting on any other condition
+// are polled on every pass, except those in PT_YIELD_EVENT, which
+// are parked until their event or timeout (see PT_EVENT below).
+// Between passes the core sleeps in __wfe until the next
+// deadline: an interrupt or a __sev() from the other core wakes it
+// early, and pt_poll_usec bounds the sleep while anything is being
+// polled.
+#define PT_NO_WAKE UINT64_MAX
+// deadline asked for by the timed yield the thread just made, per core
+uint64_t pt_wake_request = PT_NO_WAKE, pt_wake_request1 = PT_NO_WAKE ;
+// longest sleep while a thread waits on a condition
+int pt_poll_usec = 100 ;
+
+// the condition of the timed yields: true once deadline has passed,
+// otherwise leaves the deadline for the scheduler
+static inline int pt_wait_until(uint64_t deadline) {
+  if (time_us_64() >= deadline) return 1 ;
+  if (get_core_num()==1) pt_wake_request1 = deadline ;
+  else pt_wake_request = deadline ;
+  return 0 ;
+}
+
+// =========================================
+// PT_EVENT: up to 32 event flags shared by both cores. Any code,
+// interrupt handlers included, sets them with pt_event_signal(),
+// which also wakes a core sleeping in __wfe. A thread waits on a
+// mask of them with PT_YIELD_EVENT (above), which takes the bits
+// it was woken by. The deadline scheduler parks waiting threads
+// instead of polling them and calls them as soon as one of their
+// events is set; the other schedulers poll them like any yield.
+// The bit numbers are the application's to assign.
+volatile uint32_t pt_events ;
+// bits the last PT_YIELD_EVENT on each core returned with
+uint32_t pt_event_taken, pt_event_taken1 ;
+// events waited for by the thread just called, per core
+uint32_t pt_event_request, pt_event_request1 ;
+// the signal can come from either core, in or out of an interrupt.
+// 16-23 are the SDK's striped locks and 24, 25 are lock_lock and
+// sem_lock above, so this takes the first of the PT_LOCK numbers
+#define PT_EVENT_LOCK 26
+#define pt_event_lock spin_lock_instance(PT_EVENT_LOCK)
+
+static inline void pt_event_signal(uint32_t mask) {
+  uint32_t irq = spin_lock_blocking(pt_event_lock) ;
+  pt_events = pt_events | mask ;
+  spin_unlock(pt_event_lock, irq) ;
+  __sev() ;
+}
+
+// clears and returns the bits of mask that were set
+static inline uint32_t pt_event_take(uint32_t mask) {
+  uint32_t irq = spin_lock_blocking(pt_event_lock) ;
+  uint32_t taken = pt_events & mask ;
+  pt_events = pt_events & ~taken ;
+  spin_unlock(pt_event_lock, irq) ;
+  return taken ;
+}
+
+// leaves deadline and mask for the scheduler without testing or
+// taking anything: what a timed yield's first return asks for
+static inline void pt_wait_request(uint32_t mask, uint64_t deadline) {
+  if (get_core_num()==1) { pt_event_request1 = mask ; pt_wake_request1 = deadline ; }
+  else { pt_event_request = mask ; pt_wake_request = deadline ; }
+}
+
+// the condition of PT_YIELD_EVENT: true once an event in mask is
+// set or deadline has passed, otherwise leaves both for the scheduler
+static inline int pt_wait_event(uint32_t mask, uint64_t deadline) {
+  int core = get_core_num() ;
+  uint32_t taken = (pt_events & mask) ? pt_event_take(mask) : 0 ;
+  if (taken || time_us_64() >= deadline) {
+    if (core==1) pt_event_taken1 = taken ;
+    else pt_event_taken = taken ;
+    return 1 ;
+  }
+  if (core==1) { pt_event_request1 = mask ; pt_wake_request1 = deadline ; }
+  else { pt_event_request = mask ; pt_wake_request = deadline ; }
+  return 0 ;
+}
+
+// sleeping threads of one core, soonest wake time at the root
+struct pt_deadline_heap {
+  int n ;
+  unsigned char thread[MAX_THREADS] ;
+  uint64_t wake[MAX_THREADS] ;
+} ;
+
+static void pt_heap_push(struct pt_deadline_heap *h, int thread, uint64_t wake) {
+  int i = h->n++ ;
+  while (i > 0 && h->wake[(i-1)/2] > wake) {
+    h->thread[i] = h->thread[(i-1)/2] ;
+    h->wake[i] = h->wake[(i-1)/2] ;
+    i = (i-1)/2 ;
+  }
+  h->thread[i] = thread ;
+  h->wake[i] = wake ;
+}
+
+// threads of one core parked on events, with their timeouts
+struct pt_event_waiters {
+  int n ;
+  unsigned char thread[MAX_THREADS] ;
+  uint32_t mask[MAX_THREADS] ;
+  uint64_t wake[MAX_THREADS] ;
+} ;
+
+// removes and returns a waiter whose event is set or timeout has
+// passed, -1 if there is none
+static int pt_waiter_ready(struct pt_event_waiters *w, uint64_t now) {
+  int i, thread ;
+  for (i=0; i<w->n; i++) {
+    if ((pt_events & w->mask[i]) || w->wake[i] <= now) {
+      thread = w->thread[i] ;
+      w->n-- ;
+      w->thread[i] = w->thread[w->n] ;
+      w->mask[i] = w->mask[w->n] ;
+      w->wake[i] = w->wake[w->n] ;
+      return thread ;
+    }
+  }
+  return -1 ;
+}
+
+static int pt_heap_pop(struct pt_deadline_heap *h) {
+  int top = h->thread[0] ;
+  int last = --h->n ;
+  int i = 0 ;
+  while (2*i+1 < last) {
+    int c = 2*i+1 ;
+    if (c+1 < last && h->wake[c+1] < h->wake[c]) c++ ;
+    if (h->wake[last] <= h->wake[c]) break ;
+    h->thread[i] = h->thread[c] ;
+    h->wake[i] = h->wake[c] ;
+    i = c ;
+  }
+  h->thread[i] = h->thread[last] ;
+  h->wake[i] = h->wake[last] ;
+  return top ;
+}
+
 // =========================================
 // If defined, accumulates execution stats, 
 //    but slows down scheduler!!
@@ -791,6 +969,140 @@ int sched_thread_stats[MAX_THREADS], sched_thread_stats1[MAX_THREADS] ;
 uint64_t sched_thread_time[MAX_THREADS], thread_time ;
 uint64_t sched_thread_time1[MAX_THREADS], thread_time1 ;
 int sched_count, sched_count1 ;
+
+// per-thread stats kept by both schedulers in both modes:
+// two time_us_32() reads per thread call, so idle polls cost
+// well under a microsecond each
+struct pt_thread_stats {
+  uint32_t calls ;       // times the scheduler called the thread
+  uint32_t runs ;        // calls that got past a yield or started from the top
+  uint64_t run_us ;      // time spent in the thread, all calls
+  uint32_t max_run_us ;  // longest single call
+  uint32_t wakeups ;     // PT_YIELD_usec / PT_YIELD_UNTIL_usec deadlines reached
+  uint64_t late_us ;     // total time woken past those deadlines
+  uint32_t max_late_us ; // worst wake-up lateness
+} ;
+struct pt_thread_stats pt_stats[MAX_THREADS], pt_stats1[MAX_THREADS] ;
+// thread the scheduler is running, per core
+int pt_current_thread, pt_current_thread1 ;
+
+// called by a thread as it wakes from a timed yield
+static inline void pt_record_wakeup(uint64_t deadline) {
+  #ifdef sched_stats
+  uint32_t late = (uint32_t)(time_us_64() - deadline) ;
+  struct pt_thread_stats *s = (get_core_num()==1) ? &pt_stats1[pt_current_thread1] : &pt_stats[pt_current_thread] ;
+  s->wakeups++ ;
+  s->late_us += late ;
+  if (late > s->max_late_us) s->max_late_us = late ;
+  #endif
+}
+
+// pt_stats_reset() from the other core only asks: each core's
+// scheduler clears its own stats, between thread calls
+volatile int pt_stats_clear_request[2] ;
+
+static void pt_stats_clear(struct pt_thread_stats *s) {
+  for (int i=0; i<MAX_THREADS; i++) {
+    s[i] = (struct pt_thread_stats){0} ;
+  }
+}
+
+// called by a scheduler after each thread call
+static inline void pt_record_call(struct pt_thread_stats *s, int ran, uint32_t start) {
+  uint32_t t = time_us_32() - start ;
+  int core = get_core_num() ;
+  if (pt_stats_clear_request[core]) {
+    pt_stats_clear_request[core] = 0 ;
+    pt_stats_clear(core ? pt_stats1 : pt_stats) ;
+    return ; // the call straddled the reset
+  }
+  s->calls++ ;
+  s->runs += ran ;
+  s->run_us += t ;
+  if (t > s->max_run_us) s->max_run_us = t ;
+}
+
+// clear one core's thread stats: now if called on that core,
+// else after its scheduler's next thread call
+void pt_stats_reset(int core) {
+  if (core == (int)get_core_num()) pt_stats_clear(core ? pt_stats1 : pt_stats) ;
+  else pt_stats_clear_request[core] = 1 ;
+}
+
+// print one core's thread stats, one line per thread
+void pt_stats_print(int core) {
+  struct pt_thread_stats *s = core ? pt_stats1 : pt_stats ;
+  struct ptx *list = core ? pt_thread_list1 : pt_thread_list ;
+  int count = core ? pt_task_count1 : pt_task_count ;
+  if (count == 0) return ;
+  printf("core %d thread                  runs   run ms  max run us  wakeups  avg late us  max late us\n", core) ;
+  for (int i=0; i<count; i++) {
+    printf("  %-26s %7lu %8lu %11lu %8lu %12lu %12lu\n", list[i].name ? list[i].name : "?",
+           (unsigned long)s[i].runs, (unsigned long)(s[i].run_us / 1000), (unsigned long)s[i].max_run_us,
+           (unsigned long)s[i].wakeups, (unsigned long)(s[i].wakeups ? s[i].late_us / s[i].wakeups : 0),
+           (unsigned long)s[i].max_late_us) ;
+  }
+}
+
+// SCHED_DEADLINE scheduler loop for one core's thread list; never returns
+static void pt_run_deadline(struct ptx *list, int count, int core) {
+  static struct pt_deadline_heap heaps[2] ;
+  static struct pt_event_waiters waiters[2] ;
+  struct pt_deadline_heap *h = &heaps[core] ;
+  struct pt_event_waiters *w = &waiters[core] ;
+  uint64_t *request = core ? &pt_wake_request1 : &pt_wake_request ;
+  uint32_t *event_request = core ? &pt_event_request1 : &pt_event_request ;
+  int *executed = core ? &pt_executed1 : &pt_executed ;
+  int *current = core ? &pt_current_thread1 : &pt_current_thread ;
+  unsigned char polled[MAX_THREADS], next_polled[MAX_THREADS] ;
+  int npolled = count, nnext, next, i ;
+  // every thread is called once to start with
+  for (i=0; i<count; i++) polled[i] = i ;
+  while(1) {
+    nnext = 0 ;
+    next = 0 ;
+    // signalled waiters, then due sleepers, then the polled threads once each
+    while(1) {
+      if ((i = pt_waiter_ready(w, time_us_64())) >= 0) ;
+      else if (h->n && h->wake[0] <= time_us_64()) i = pt_heap_pop(h) ;
+      else if (next < npolled) i = polled[next++] ;
+      else break ;
+      *request = PT_NO_WAKE ;
+      *event_request = 0 ;
+      *executed = 0 ;
+      *current = i ;
+      #ifdef sched_stats
+      int top = (list[i].pt.lc == 0) ;
+      uint32_t start = time_us_32() ;
+      #endif
+      (list[i].pf)(&list[i].pt) ;
+      #ifdef sched_stats
+      pt_record_call(core ? &pt_stats1[i] : &pt_stats[i], top | *executed, start) ;
+      #endif
+      // an event wait is parked, a timed yield that isn't due goes back
+      // in the heap, anything else is polled
+      if (*event_request) {
+        w->thread[w->n] = i ;
+        w->mask[w->n] = *event_request ;
+        w->wake[w->n] = *request ;
+        w->n++ ;
+      }
+      else if (*request != PT_NO_WAKE) pt_heap_push(h, i, *request) ;
+      else next_polled[nnext++] = i ;
+    }
+    for (npolled=0; npolled<nnext; npolled++) polled[npolled] = next_polled[npolled] ;
+    // sleep until the next deadline, an interrupt or an event
+    uint64_t now = time_us_64() ;
+    uint64_t wake = h->n ? h->wake[0] : PT_NO_WAKE ;
+    for (i=0; i<w->n; i++) {
+      if (pt_events & w->mask[i]) wake = now ; // signalled since the pass
+      if (w->wake[i] < wake) wake = w->wake[i] ;
+    }
+    if (npolled && wake > now + pt_poll_usec) wake = now + pt_poll_usec ;
+    if (wake == PT_NO_WAKE) __wfe() ;
+    else if (wake > now) best_effort_wfe_or_timeout(from_us_since_boot(wake)) ;
+  }
+}
 // =========================================
 
 static PT_THREAD (protothread_sched(struct pt *pt))
@@ -807,8 +1119,18 @@ static PT_THREAD (protothread_sched(struct pt *pt))
           // -- loop can have more than one initialization or increment/decrement, 
           // -- separated using comma operator. But it can have only one condition.
           for (i=0; i<pt_task_count; i++, ptx++ ){
+              #ifdef sched_stats
+              // a thread ran if it got past a yield or started from the top
+              int top = (ptx->pt.lc == 0) ;
+              pt_executed = 0;
+              pt_current_thread = i;
+              uint32_t start = time_us_32();
+              #endif
               // call thread function
               (pt_thread_list[i].pf)(&ptx->pt); 
+              #ifdef sched_stats
+              pt_record_call(&pt_stats[i], top | pt_executed, start);
+              #endif
           }
           // Never yields! 
           // NEVER exit while!
@@ -830,10 +1152,17 @@ static PT_THREAD (protothread_sched(struct pt *pt))
           // -- separated using comma operator. But it can have only one condition.
           for (i=0; i<pt_task_count; i++, ptx++ ){
               // zero execute flag
+              #ifdef sched_stats
+              int top = (ptx->pt.lc == 0) ;
+              #endif
               pt_executed = 0;
+              pt_current_thread = i;
               thread_time = time_us_64();
               // call thread function
               (pt_thread_list[i].pf)(&ptx->pt); 
+              #ifdef sched_stats
+              pt_record_call(&pt_stats[i], top | pt_executed, (uint32_t)thread_time);
+              #endif
               // if there was execution, then restart execution list
               if (pt_executed==1){
                 #ifdef sched_stats
@@ -847,6 +1176,11 @@ static PT_THREAD (protothread_sched(struct pt *pt))
           // NEVER exit while!
         } // END WHILE(1)
     } //end if (pt_sched_method==priority) 
+    //
+    if (pt_sched_method==SCHED_DEADLINE){
+        // never returns
+        pt_run_deadline(pt_thread_list, pt_task_count, 0);
+    } //end if (pt_sched_method==SCHED_DEADLINE)
     
     PT_END(pt);
 } // scheduler thread
@@ -868,8 +1202,18 @@ static PT_THREAD (protothread_sched1(struct pt *pt))
           // -- loop can have more than one initialization or increment/decrement, 
           // -- separated using comma operator. But it can have only one condition.
           for (i=0; i<pt_task_count1; i++, ptx++ ){
+              #ifdef sched_stats
+              // a thread ran if it got past a yield or started from the top
+              int top = (ptx->pt.lc == 0) ;
+              pt_executed1 = 0;
+              pt_current_thread1 = i;
+              uint32_t start = time_us_32();
+              #endif
               // call thread function
               (pt_thread_list1[i].pf)(&ptx->pt); 
+              #ifdef sched_stats
+              pt_record_call(&pt_stats1[i], top | pt_executed1, start);
+              #endif
           }
           // Never yields! 
           // NEVER exit while!
@@ -891,10 +1235,17 @@ static PT_THREAD (protothread_sched1(struct pt *pt))
           // -- separated using comma operator. But it can have only one condition.
           for (i=0; i<pt_task_count1; i++, ptx++ ){
               // zero execute flag
+              #ifdef sched_stats
+              int top = (ptx->pt.lc == 0) ;
+              #endif
               pt_executed1 = 0;
+              pt_current_thread1 = i;
               thread_time1 = time_us_64();
               // call thread function
               (pt_thread_list1[i].pf)(&ptx->pt); 
+              #ifdef sched_stats
+              pt_record_call(&pt_stats1[i], top | pt_executed1, (uint32_t)thread_time1);
+              #endif
               // if there was execution, then restart execution list
               if (pt_executed1==1){
                 #ifdef sched_stats
@@ -908,6 +1259,11 @@ static PT_THREAD (protothread_sched1(struct pt *pt))
           // NEVER exit while!
         } // END WHILE(1)
     } //end if (pt_sched_method==priority)   
+    //
+    if (pt_sched_method==SCHED_DEADLINE){
+        // never returns
+        pt_run_deadline(pt_thread_list1, pt_task_count1, 1);
+    } //end if (pt_sched_method==SCHED_DEADLINE)
      
     PT_END(pt);
 } // scheduler1 thread
@@ -927,9 +1283,9 @@ static PT_THREAD (protothread_sched1(struct pt *pt))
 // === package the add thread ==========================
 #define pt_add_thread(thread_name) do{\
   if(get_core_num()==1){ \
-    pt_add1(thread_name);\
+    if (pt_task_count1 < MAX_THREADS) pt_thread_list1[pt_add1(thread_name)].name = #thread_name;\
   }  else {\
-    pt_add(thread_name);\
+    if (pt_task_count < MAX_THREADS) pt_thread_list[pt_add(thread_name)].name = #thread_name;\
   }\
 } while(0) 
 
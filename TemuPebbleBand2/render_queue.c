@@ -0,0 +1,84 @@
+/**
+ * Frame command queue from the game to the renderer -- see render_queue.h
+ */
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "render_queue.h"
+
+render_queue_stats renderQueueStats;
+
+static render_cmd queue[RENDER_QUEUE_SIZE];
+static volatile uint16_t head; // next slot to write, producer only
+static volatile uint16_t tail; // next slot to read, consumer only
+static render_executor executor;
+static unsigned int renderCore; // core that runs the commands
+
+/**
+ * @brief Empties the queue and sets who runs the commands, and on which core
+ * Call before either side starts.
+ */
+void render_queue_init(render_executor execute, unsigned int core)
+{
+    head = 0;
+    tail = 0;
+    executor = execute;
+    renderCore = core;
+}
+
+/**
+ * @brief Queues a command; producer side
+ * Waits for the renderer if the queue is full.
+ */
+void render_queue_push(const render_cmd *cmd)
+{
+    uint16_t next = (head + 1) & (RENDER_QUEUE_SIZE - 1);
+    if (next == tail)
+    {
+        renderQueueStats.stalls++;
+        if (get_core_num() == renderCore)
+        {
+            render_queue_drain(); // nobody else will
+        }
+        while (next == tail)
+        {
+            tight_loop_contents();
+        }
+    }
+    queue[head] = *cmd;
+    __sync_synchronize(); // command written before it is published
+    head = next;
+    __sev(); // wake the render core if it is sleeping in __wfe
+
+    unsigned int depth = (next - tail) & (RENDER_QUEUE_SIZE - 1);
+    renderQueueStats.pushed++;
+    if (depth > renderQueueStats.maxDepth)
+    {
+        renderQueueStats.maxDepth = depth;
+    }
+}
+
+/**
+ * @brief True if commands are waiting
+ */
+bool render_queue_pending(void)
+{
+    return tail != head;
+}
+
+/**
+ * @brief Runs every queued command, oldest first; consumer side
+ * @return number of commands run
+ */
+int render_queue_drain(void)
+{
+    int n = 0;
+    while (tail != head)
+    {
+        __sync_synchronize(); // head read before the command it publishes
+        executor(&queue[tail]);
+        __sync_synchronize(); // command used before its slot is handed back
+        tail = (tail + 1) & (RENDER_QUEUE_SIZE - 1);
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,46 @@
+/**
+ * Frame command queue from the game to the renderer.
+ *
+ * The game never draws. It describes each change to the screen as a
+ * small command carrying every value the drawing needs, and the core
+ * that owns the frame buffer replays the commands in order. Commands
+ * are never dropped, because the screen is drawn incrementally: a
+ * producer that finds the queue full waits for the renderer, or runs
+ * the commands itself if it is the rendering core.
+ *
+ * Single producer, single consumer; the barriers make it safe between
+ * cores. What a command means is up to the executor passed to
+ * render_queue_init().
+ */
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RENDER_QUEUE_SIZE 512 // commands, power of two
+
+typedef struct render_cmd
+{
+    uint8_t op;         // executor-defined command
+    uint8_t a, b, c;    // small arguments
+    int16_t x, y, w, h; // coordinates or values
+} render_cmd;
+
+typedef void (*render_executor)(const render_cmd *cmd);
+
+typedef struct render_queue_stats
+{
+    unsigned int pushed;   // commands queued
+    unsigned int stalls;   // pushes that found the queue full
+    unsigned int maxDepth; // most commands waiting at once
+} render_queue_stats;
+
+extern render_queue_stats renderQueueStats;
+
+void render_queue_init(render_executor execute, unsigned int core);
+void render_queue_push(const render_cmd *cmd);
+bool render_queue_pending(void);
+int render_queue_drain(void);
+
+#endif
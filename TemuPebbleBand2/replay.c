@@ -0,0 +1,172 @@
+/**
+ * Input recording and deterministic replay -- see replay.h
+ */
+#include <stdio.h>
+#include "replay.h"
+
+#define NO_START 0xFFFFFFFFu
+
+static replay_record replayLog[REPLAY_LOG_SIZE];
+static uint32_t written;              // records ever written; the newest is written - 1
+static uint32_t lastStart = NO_START; // index of the newest REPLAY_START
+static bool recording;
+static bool playing;
+static uint32_t cursor;               // next record to play back
+static uint32_t end;                  // one past the last record of the game being played
+
+static void append(const replay_record *rec)
+{
+    replayLog[written & (REPLAY_LOG_SIZE - 1)] = *rec;
+    written++;
+}
+
+// the newest game's start is still in the ring
+static bool start_kept(void)
+{
+    return lastStart != NO_START && written - lastStart <= REPLAY_LOG_SIZE;
+}
+
+/**
+ * @brief Starts recording a game
+ * @param lives lives the game starts with, -1 for none
+ * @param seed value rand() was seeded with for this game
+ */
+void replay_record_start(int selection, int lives, uint32_t seed)
+{
+    replay_record rec = {seed, REPLAY_START, (uint8_t)selection, (uint8_t)(int8_t)lives, 0};
+    lastStart = written;
+    append(&rec);
+    recording = true;
+}
+
+/**
+ * @brief Records a setting the game was started with, if a game is being recorded
+ * @param setting a REPLAY_SET_ id
+ */
+void replay_record_setting(int setting, uint32_t value)
+{
+    if (!recording)
+    {
+        return;
+    }
+    replay_record rec = {value, REPLAY_SETTING, (uint8_t)setting, 0, 0};
+    append(&rec);
+}
+
+/**
+ * @brief Records a key edge the game handled, if a game is being recorded
+ * @param songTime the edge's time_us minus the song's time 0
+ */
+void replay_record_event(const input_event *ev, int32_t songTime)
+{
+    if (!recording)
+    {
+        return;
+    }
+    replay_record rec = {(uint32_t)songTime, REPLAY_EVENT, ev->source, ev->key, ev->down};
+    append(&rec);
+}
+
+/**
+ * @brief Starts playing back the newest recorded game
+ * @param start filled with the game's REPLAY_START record
+ * @return false if nothing was recorded or the game's start was overwritten
+ */
+bool replay_begin(replay_record *start)
+{
+    if (!start_kept())
+    {
+        return false;
+    }
+    *start = replayLog[lastStart & (REPLAY_LOG_SIZE - 1)];
+    cursor = lastStart + 1;
+    end = written;
+    recording = false;
+    playing = true;
+    return true;
+}
+
+/**
+ * @brief Takes the next of the settings recorded after the game's start
+ * Called after replay_begin() and before the first replay_next().
+ * @return false once the settings are used up (recordings without any have none)
+ */
+bool replay_next_setting(int *setting, uint32_t *value)
+{
+    if (!playing || cursor == end)
+    {
+        return false;
+    }
+    const replay_record *rec = &replayLog[cursor & (REPLAY_LOG_SIZE - 1)];
+    if (rec->kind != REPLAY_SETTING)
+    {
+        return false;
+    }
+    *setting = rec->source;
+    *value = rec->time_us;
+    cursor++;
+    return true;
+}
+
+/**
+ * @brief Takes the next recorded edge that is due by songTime
+ * @param ev filled with the edge; its time_us is the offset from song time 0
+ * @return false if no edge is due yet or the recording has run out
+ */
+bool replay_next(int32_t songTime, input_event *ev)
+{
+    if (!playing || cursor == end)
+    {
+        return false;
+    }
+    const replay_record *rec = &replayLog[cursor & (REPLAY_LOG_SIZE - 1)];
+    if ((int32_t)rec->time_us > songTime)
+    {
+        return false;
+    }
+    ev->source = rec->source;
+    ev->key = rec->key;
+    ev->down = rec->down;
+    ev->time_us = rec->time_us;
+    cursor++;
+    return true;
+}
+
+/**
+ * @brief Ends the recording or playback of the current game
+ */
+void replay_stop(void)
+{
+    recording = false;
+    playing = false;
+}
+
+bool replay_recording(void)
+{
+    return recording;
+}
+
+bool replay_playing(void)
+{
+    return playing;
+}
+
+/**
+ * @brief Prints the newest recorded game, one "rec" line per record
+ * Fields: time_us (hex), kind, source, key, down, as in replay_record.
+ */
+void replay_dump(void)
+{
+    if (lastStart == NO_START)
+    {
+        printf("replay: nothing recorded\n");
+        return;
+    }
+    uint32_t first = start_kept() ? lastStart : written - REPLAY_LOG_SIZE;
+    printf("replay: %u records%s\n", (unsigned int)(written - first), start_kept() ? "" : ", start overwritten");
+    for (uint32_t i = first; i != written; i++)
+    {
+        const replay_record *rec = &replayLog[i & (REPLAY_LOG_SIZE - 1)];
+        printf("rec %08lx %u %u %u %u\n", (unsigned long)rec->time_us, rec->kind, rec->source, rec->key, rec->down);
+    }
+}
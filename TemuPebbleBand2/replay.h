@@ -0,0 +1,59 @@
+/**
+ * Input recording and deterministic replay.
+ *
+ * Every game is recorded into a RAM ring as fixed 8-byte records: one
+ * REPLAY_START with the menu selection, lives and rand() seed the game
+ * was started with, one REPLAY_SETTING for each setting the console can
+ * change that the game depends on (scroll speed, judging windows), then
+ * one REPLAY_EVENT per key edge the game handled, timed from the song's
+ * time 0. Playing a recording back puts the settings back, starts the
+ * game the same way and hands the same edges, with the same timestamps
+ * relative to the song, to the same key callbacks, so judging and
+ * scoring come out identical.
+ *
+ * replay_dump() prints the last game as text lines over stdio; the
+ * "rec" lines can be pasted into host-side runs. The ring keeps the
+ * newest records, so a game longer than REPLAY_LOG_SIZE records loses
+ * its start and can no longer be played back.
+ */
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "input_events.h"
+
+#define REPLAY_LOG_SIZE 1024 // records, power of two: 8 KB
+
+// record kinds
+#define REPLAY_START 1
+#define REPLAY_EVENT 2
+#define REPLAY_SETTING 3
+
+// REPLAY_SETTING ids
+#define REPLAY_SET_GRAVITY 0 // fix15 pixels per frame
+#define REPLAY_SET_PERFECT 1 // judging windows in us, in judgeWindowUs order
+#define REPLAY_SET_GOOD 2
+#define REPLAY_SET_BAD 3
+
+typedef struct replay_record
+{
+    uint32_t time_us; // EVENT: signed offset from song time 0; START: rand() seed; SETTING: value
+    uint8_t kind;     // REPLAY_START, REPLAY_EVENT or REPLAY_SETTING
+    uint8_t source;   // EVENT: INPUT_PIANO or INPUT_KEYPAD; START: menu selection; SETTING: REPLAY_SET_ id
+    uint8_t key;      // EVENT: scanner key number; START: lives (as int8_t, -1 for none)
+    uint8_t down;     // EVENT: 1 pressed, 0 released
+} replay_record;
+
+void replay_record_start(int selection, int lives, uint32_t seed);
+void replay_record_setting(int setting, uint32_t value);
+void replay_record_event(const input_event *ev, int32_t songTime);
+bool replay_begin(replay_record *start);
+bool replay_next_setting(int *setting, uint32_t *value);
+bool replay_next(int32_t songTime, input_event *ev);
+void replay_stop(void);
+bool replay_recording(void);
+bool replay_playing(void);
+void replay_dump(void);
+
+#endif
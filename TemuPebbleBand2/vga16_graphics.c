@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
 #include "hardware/dma.h"
@@ -153,12 +154,9 @@ void initVGA() {
 // a DMA channel, we only need to modify the contents of the array and the
 // pixels will be automatically updated on the screen.
 void drawPixel(short x, short y, char color) {
-    // Range checks (640x480 display)
-    if (x > 639) x = 639 ;
-    if (x < 0) x = 0 ;
-    if (y < 0) y = 0 ;
-    if (y > 479) y = 479 ;
-    //if((x > 639) | (x < 0) | (y > 479) | (y < 0) ) return;
+    // Range check (640x480 display) -- off-screen pixels are dropped,
+    // not clamped to the edge. One unsigned compare covers both sides.
+    if (((unsigned short)x > 639) | ((unsigned short)y > 479)) return;
 
     // Which pixel is it?
     int pixel = ((640 * y) + x) ;
@@ -174,16 +172,50 @@ void drawPixel(short x, short y, char color) {
     }
 }
 
+// Fill pixels [x0, x1) of row y. Coordinates must already be clipped.
+// Whole bytes (pixel pairs) are written with memset; only an odd pixel
+// at either end needs a read-modify-write.
+static void fillSpan(short x0, short x1, short y, char color) {
+    unsigned char *row = &vga_data_array[y * (_width/2)] ;
+    if (x0 & 1) {
+        row[x0>>1] = (row[x0>>1] & TOPMASK) | (color << 4) ;
+        x0++ ;
+    }
+    if (x1 & 1) {
+        x1-- ;
+        row[x1>>1] = (row[x1>>1] & BOTTOMMASK) | (color) ;
+    }
+    if (x1 > x0) {
+        memset(&row[x0>>1], (unsigned char)((color << 4) | color), (x1 - x0) >> 1) ;
+    }
+}
+
+// Clip a rectangle to the screen once, so the drawing loops below never
+// test coordinates. Returns 0 if nothing is left to draw.
+static inline char clipRect(int *x0, int *y0, int *x1, int *y1) {
+    if (*x0 < 0) *x0 = 0 ;
+    if (*y0 < 0) *y0 = 0 ;
+    if (*x1 > _width) *x1 = _width ;
+    if (*y1 > _height) *y1 = _height ;
+    return (*x0 < *x1) && (*y0 < *y1) ;
+}
+
 void drawVLine(short x, short y, short h, char color) {
-    for (short i=y; i<(y+h); i++) {
-        drawPixel(x, i, color) ;
+    int x0 = x, y0 = y, x1 = x + 1, y1 = y + h ;
+    if (!clipRect(&x0, &y0, &x1, &y1)) return ;
+    // same nibble of every row: precompute the mask and shifted color
+    unsigned char *p = &vga_data_array[(y0 * _width + x0) >> 1] ;
+    unsigned char keep = (x0 & 1) ? TOPMASK : BOTTOMMASK ;
+    unsigned char bits = (x0 & 1) ? (color << 4) : (color & TOPMASK) ;
+    for (int j=y0; j<y1; j++, p += _width/2) {
+        *p = (*p & keep) | bits ;
     }
 }
 
 void drawHLine(short x, short y, short w, char color) {
-    for (short i=x; i<(x+w); i++) {
-        drawPixel(i, y, color) ;
-    }
+    int x0 = x, y0 = y, x1 = x + w, y1 = y + 1 ;
+    if (!clipRect(&x0, &y0, &x1, &y1)) return ;
+    fillSpan(x0, x1, y0, color) ;
 }
 
 // Bresenham's algorithm - thx wikipedia and thx Bruce!
@@ -338,23 +370,31 @@ void drawCircleHelper( short x0, short y0, short r, unsigned char cornername, ch
   }
 }
 
-void fillCircle(short x0, short y0, short r, char color) {
-/* Draw a filled circle with center (x0,y0) and radius r, with given color
- * Parameters:
- *      x0: x-coordinate of center of circle. The top-left of the screen
- *          has x-coordinate 0 and increases to the right
- *      y0: y-coordinate of center of circle. The top-left of the screen
- *          has y-coordinate 0 and increases to the bottom
- *      r:  radius of circle
- *      color: 16-bit color value for the circle
- * Returns: Nothing
- */
-  drawVLine(x0, y0-r, 2*r+1, color);
-  fillCircleHelper(x0, y0, r, 3, 0, color);
+// Rows of a filled arc, as horizontal spans. The row k pixels above yt
+// and k pixels below yb is filled out to hw pixels beyond the arc
+// centers xl (left) and xr (right). corners: 0x1 right side, 0x2 left
+// side, 0x4 also fill between xl and xr.
+static void fillArcRows(short xl, short xr, short yt, short yb, short k, short hw,
+                        unsigned char corners, char color) {
+  if (k <= 0) return ;
+  short rows[2] = {yt - k, yb + k} ;
+  for (char n=0; n<2; n++) {
+    if (corners == 0x7) {
+      drawHLine(xl - hw, rows[n], xr - xl + 2*hw + 1, color) ;
+      continue ;
+    }
+    if (corners & 0x2) drawHLine(xl - hw, rows[n], hw, color) ;
+    if (corners & 0x4) drawHLine(xl, rows[n], xr - xl + 1, color) ;
+    if (corners & 0x1) drawHLine(xr + 1, rows[n], hw, color) ;
+  }
 }
 
-void fillCircleHelper(short x0, short y0, short r, unsigned char cornername, short delta, char color) {
-// Helper function for drawing filled circles
+// Same midpoint walk as drawCircleHelper, but emitting whole rows.
+// Each step (x,y) means row x reaches out y pixels; row y reaches out
+// x pixels, and is emitted once, just before y moves on. The union of
+// rows is exactly the set of pixels the old column-wise fill drew.
+static void fillArcs(short xl, short xr, short yt, short yb, short r,
+                     unsigned char corners, char color) {
   short f     = 1 - r;
   short ddF_x = 1;
   short ddF_y = -2 * r;
@@ -363,6 +403,7 @@ void fillCircleHelper(short x0, short y0, short r, unsigned char cornername, sho
 
   while (x<y) {
     if (f >= 0) {
+      fillArcRows(xl, xr, yt, yb, y, x, corners, color) ;
       y--;
       ddF_y += 2;
       f     += ddF_y;
@@ -370,16 +411,33 @@ void fillCircleHelper(short x0, short y0, short r, unsigned char cornername, sho
     x++;
     ddF_x += 2;
     f     += ddF_x;
-
-    if (cornername & 0x1) {
-      drawVLine(x0+x, y0-y, 2*y+1+delta, color);
-      drawVLine(x0+y, y0-x, 2*x+1+delta, color);
-    }
-    if (cornername & 0x2) {
-      drawVLine(x0-x, y0-y, 2*y+1+delta, color);
-      drawVLine(x0-y, y0-x, 2*x+1+delta, color);
-    }
+    fillArcRows(xl, xr, yt, yb, x, y, corners, color) ;
   }
+  fillArcRows(xl, xr, yt, yb, y, x, corners, color) ;
+}
+
+void fillCircle(short x0, short y0, short r, char color) {
+/* Draw a filled circle with center (x0,y0) and radius r, with given color
+ * Parameters:
+ *      x0: x-coordinate of center of circle. The top-left of the screen
+ *          has x-coordinate 0 and increases to the right
+ *      y0: y-coordinate of center of circle. The top-left of the screen
+ *          has y-coordinate 0 and increases to the bottom
+ *      r:  radius of circle
+ *      color: 16-bit color value for the circle
+ * Returns: Nothing
+ */
+  drawHLine(x0-r, y0, 2*r+1, color);
+  fillArcs(x0, x0, y0, y0, r, 0x7, color);
+}
+
+void fillCircleHelper(short x0, short y0, short r, unsigned char cornername, short delta, char color) {
+// Helper function for drawing filled circles: the right (0x1) and/or
+// left (0x2) half, not including the center column, stretched down by delta
+// (the old column walk also painted the center column when r == 1)
+  if (cornername & 0x1) fillRect(x0+1, y0, r, delta+1, color);
+  if (cornername & 0x2) fillRect(x0-r, y0, r, delta+1, color);
+  fillArcs(x0, x0, y0, y0+delta, r, cornername & 0x3, color);
 }
 
 // Draw a rounded rectangle
@@ -410,12 +468,10 @@ void drawRoundRect(short x, short y, short w, short h, short r, char color) {
 
 // Fill a rounded rectangle
 void fillRoundRect(short x, short y, short w, short h, short r, char color) {
-  // smarter version
-  fillRect(x+r, y, w-2*r, h, color);
-
-  // draw four corners
-  fillCircleHelper(x+w-r-1, y+r, r, 1, h-2*r-1, color);
-  fillCircleHelper(x+r    , y+r, r, 2, h-2*r-1, color);
+  // straight middle section, then the top and bottom rows with their
+  // rounded ends, all as horizontal spans
+  fillRect(x, y+r, w, h-2*r, color);
+  fillArcs(x+r, x+w-r-1, y+r, y+h-r-1, r, 0x7, color);
 }
 
 
@@ -434,16 +490,121 @@ void fillRect(short x, short y, short w, short h, char color) {
  * Returns:     Nothing
  */
 
-  // rudimentary clipping (drawChar w/big text requires this)
-  // if((x >= _width) || (y >= _height)) return;
-  // if((x + w - 1) >= _width)  w = _width  - x;
-  // if((y + h - 1) >= _height) h = _height - y;
+  // clip once; rectangles entirely off-screen (e.g. notes spawned
+  // above the top edge) cost nothing
+  int x0 = x, y0 = y, x1 = x + w, y1 = y + h ;
+  if (!clipRect(&x0, &y0, &x1, &y1)) return ;
+
+  // row by row, so each row is one contiguous span of bytes
+  for(int j=y0; j<y1; j++) {
+    fillSpan(x0, x1, j, color);
+  }
+}
+
+// === glyph cache ====================================================
+// Text is the hottest path in the game HUD: a size-2 drawChar is 48
+// fillRects, each of which is 4 drawPixel read-modify-writes. The cache
+// below keeps glyphs already expanded into framebuffer format (two 4-bit
+// pixels per byte) for every (font, char, size, fg, bg, x-parity) that
+// is actually drawn, so a glyph becomes a handful of byte-span copies.
+// Only opaque text (fg != bg) that is fully on-screen takes the fast path.
+
+// Number of cached glyphs (power of two, direct-mapped)
+#ifndef GLYPH_CACHE_SLOTS
+#define GLYPH_CACHE_SLOTS 64
+#endif
+// Largest drawChar size that gets cached (bigger text is rare)
+#ifndef GLYPH_CACHE_MAX_SIZE
+#define GLYPH_CACHE_MAX_SIZE 2
+#endif
+
+#define GLYPH_FONT_SMALL 0
+#define GLYPH_FONT_BIG   1
+// Room for 8 rows of the largest cached size, or 15 bigFont rows of
+// 8 pixels, both at odd x (one extra byte per row)
+#define GLYPH_SLOT_BYTES (((3*GLYPH_CACHE_MAX_SIZE + 1)*8 > 75) ? (3*GLYPH_CACHE_MAX_SIZE + 1)*8 : 75)
+
+typedef struct {
+  unsigned long key ;          // packed (face, char, size, colors, x parity), 0 = empty
+  unsigned char rowbytes ;     // framebuffer bytes per glyph row
+  unsigned char rows ;         // number of distinct rows
+  unsigned char vrep ;         // times each row is repeated vertically
+  unsigned char data[GLYPH_SLOT_BYTES] ;
+} glyph_slot ;
+
+static glyph_slot glyph_cache[GLYPH_CACHE_SLOTS] ;
+static char glyph_cache_on = 1 ;
+static unsigned long glyph_hits, glyph_misses ;
+
+void setGlyphCache(char on) {
+  glyph_cache_on = on ;
+}
+
+void getGlyphCacheStats(unsigned long *hits, unsigned long *misses) {
+  *hits = glyph_hits ;
+  *misses = glyph_misses ;
+}
 
-  // tft_setAddrWindow(x, y, x+w-1, y+h-1);
+// Find (or build) the cached expansion of one glyph
+static glyph_slot * glyphLookup(char face, unsigned char c, unsigned char size,
+                                char color, char bg, char phase) {
+  unsigned long key = 0x80000000ul | ((unsigned long)face << 20) | ((unsigned long)phase << 19) |
+                      ((unsigned long)size << 16) | ((unsigned long)(color & 0xF) << 12) |
+                      ((unsigned long)(bg & 0xF) << 8) | c ;
+  glyph_slot *slot = &glyph_cache[(c + 31*((color & 0xF) + 16*(bg & 0xF)) + 97*size + 53*phase + 71*face)
+                                  & (GLYPH_CACHE_SLOTS - 1)] ;
+  if (slot->key == key) {
+    glyph_hits++ ;
+    return slot ;
+  }
+  glyph_misses++ ;
+
+  // expand one row at a time into 4-bit pixels, then pack into bytes
+  unsigned char px[6*GLYPH_CACHE_MAX_SIZE + 10] ;
+  short width = (face == GLYPH_FONT_BIG) ? 8 : 6*size ;
+  slot->rows = (face == GLYPH_FONT_BIG) ? 15 : 8 ;
+  slot->vrep = (face == GLYPH_FONT_BIG) ? 1 : size ;
+  slot->rowbytes = (width >> 1) + phase ;
+  unsigned char *out = slot->data ;
+  for (short j=0; j<slot->rows; j++) {
+    // phase 1 glyphs start in the high nibble, so pad one pixel in front
+    px[0] = bg ;
+    for (short i=0; i<width; i++) {
+      char on ;
+      if (face == GLYPH_FONT_BIG) {
+        on = (pgm_read_byte(bigFont+((int)c*16)+j) >> (7-i)) & 1 ;
+      }
+      else {
+        short col = i / size ;
+        on = (col == 5) ? 0 : (pgm_read_byte(font+(c*5)+col) >> j) & 1 ;
+      }
+      px[i + phase] = on ? color : bg ;
+    }
+    px[width + phase] = bg ;
+    for (short k=0; k<slot->rowbytes; k++) {
+      *out++ = (px[2*k] & TOPMASK) | (px[2*k+1] << 4) ;
+    }
+  }
+  slot->key = key ;
+  return slot ;
+}
 
-  for(int i=x; i<(x+w); i++) {
-    for(int j=y; j<(y+h); j++) {
-        drawPixel(i, j, color);
+// Copy a cached glyph into the frame buffer at (x,y); caller clips
+static void glyphBlit(short x, short y, glyph_slot *slot) {
+  unsigned char *row = &vga_data_array[(_width*y + x) >> 1] ;
+  unsigned char *src = slot->data ;
+  unsigned char last = slot->rowbytes - 1 ;
+  for (short j=0; j<slot->rows; j++, src += slot->rowbytes) {
+    for (short r=0; r<slot->vrep; r++, row += _width/2) {
+      if (x & 1) {
+        // first and last bytes are shared with the neighbouring pixels
+        row[0] = (row[0] & TOPMASK) | (src[0] & BOTTOMMASK) ;
+        for (short k=1; k<last; k++) row[k] = src[k] ;
+        row[last] = (row[last] & BOTTOMMASK) | (src[last] & TOPMASK) ;
+      }
+      else {
+        for (short k=0; k<=last; k++) row[k] = src[k] ;
+      }
     }
   }
 }
@@ -457,6 +618,13 @@ void drawChar(short x, short y, unsigned char c, char color, char bg, unsigned c
      ((y + 8 * size - 1) < 0))   // Clip top
     return;
 
+  // opaque, fully visible text comes straight from the glyph cache
+  if (glyph_cache_on && (bg != color) && ((unsigned char)bg < 16) && (size <= GLYPH_CACHE_MAX_SIZE) &&
+      (x >= 0) && (y >= 0) && (x + 6*size <= _width) && (y + 8*size <= _height)) {
+    glyphBlit(x, y, glyphLookup(GLYPH_FONT_SMALL, c, size, color, bg, x & 1)) ;
+    return ;
+  }
+
   for (i=0; i<6; i++ ) {
     unsigned char line;
     if (i == 5)
@@ -573,6 +741,11 @@ inline void setTextColorBig(char color, char background) {
 void drawCharBig(short x, short y, unsigned char c, char color, char bg) {
   char i, j ;
   unsigned char line; 
+  if (glyph_cache_on && (bg != color) && ((unsigned char)bg < 16) &&
+      (x >= 0) && (y >= 0) && (x + 8 <= _width) && (y + 15 <= _height)) {
+    glyphBlit(x, y, glyphLookup(GLYPH_FONT_BIG, c, 1, color, bg, x & 1)) ;
+    return ;
+  }
   for (i=0; i<15; i++ ) {   
     line = pgm_read_byte(bigFont+((int)c*16)+i);
     for ( j = 0; j<8; j++) {
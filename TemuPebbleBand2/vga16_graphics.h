@@ -61,5 +61,8 @@ void writeStringBig(char* str) ;
 void setTextColorBig(char, char); //works, but can use usual setTextColor2
 // 5x7 font
 void writeStringBold(char* str);
+// === glyph cache: opaque text is blitted from pre-expanded glyphs
+void setGlyphCache(char on) ;
+void getGlyphCacheStats(unsigned long *hits, unsigned long *misses) ;
 // =================================================
 void drawPicture(short x, short y, unsigned short *pic, short width, short height) ;
\ No newline at end of file
@@ -0,0 +1,432 @@
+'''
+This script converts a Standard MIDI File into a note chart the game can play
+(the binary format described in TemuPebbleBand2/chart.h).
+Its steps consist of:
+1. Parse the MIDI file (format 0 or 1, every track merged) into notes and tempo changes
+2. Map each pitch onto the 13 piano lanes, C to high C (lane 0 = C ... lane 12 = high C)
+3. Rescale MIDI ticks to the chart's ticks per quarter and quantize to a grid
+4. Turn notes held for at least --sustain-min into sustains, everything else into taps
+5. Write the binary chart and/or a C header, and print a density report
+
+Only the standard library is needed.
+'''
+import argparse
+import os
+import struct
+import sys
+import time
+
+NUM_LANES = 13          # C to high C, as in key_pressed_callback_game
+NOTE_LANE_CAPACITY = 32 # note_pool.h -- notes on screen at once in one lane
+FALL_TIME_US = 1800000  # time a note is on screen at the default speed (note_lead_us)
+
+# chart event kinds (chart.h)
+CHART_TAP = 0x00
+CHART_SUSTAIN = 0x20
+CHART_TEMPO = 0x40
+CHART_SAMPLE = 0x60
+CHART_END = 0xE0
+CHART_VERSION = 1
+
+DEFAULT_US_PER_QUARTER = 500000 # MIDI default, 120 bpm
+
+
+# ============================================================================
+# MIDI parsing
+# ============================================================================
+
+class MidiError(Exception):
+    pass
+
+
+def read_vlq(data, pos):
+    """Read a MIDI variable-length quantity, return (value, new position)."""
+    value = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value = (value << 7) | (b & 0x7F)
+        if not b & 0x80:
+            return value, pos
+
+
+def parse_track(data, pos, end, track_index, notes, tempos):
+    """
+    Parse one MTrk chunk.
+    Appends (start_tick, end_tick, pitch, channel, track) to notes and
+    (tick, us_per_quarter) to tempos.
+    """
+    tick = 0
+    status = 0
+    held = {} # (channel, pitch) -> list of start ticks
+    while pos < end:
+        delta, pos = read_vlq(data, pos)
+        tick += delta
+        b = data[pos]
+        if b & 0x80:
+            status = b
+            pos += 1
+        elif status == 0:
+            raise MidiError('running status with no previous status in track %d' % track_index)
+
+        if status == 0xFF: # meta event
+            kind = data[pos]
+            length, pos = read_vlq(data, pos + 1)
+            if kind == 0x51 and length == 3:
+                tempos.append((tick, (data[pos] << 16) | (data[pos + 1] << 8) | data[pos + 2]))
+            pos += length
+            if kind == 0x2F: # end of track
+                break
+            status = 0
+            continue
+        if status in (0xF0, 0xF7): # sysex
+            length, pos = read_vlq(data, pos)
+            pos += length
+            status = 0
+            continue
+
+        kind = status & 0xF0
+        channel = status & 0x0F
+        if kind in (0x80, 0x90):
+            pitch = data[pos]
+            velocity = data[pos + 1]
+            pos += 2
+            key = (channel, pitch)
+            if kind == 0x90 and velocity > 0:
+                held.setdefault(key, []).append(tick)
+            elif held.get(key):
+                notes.append((held[key].pop(0), tick, pitch, channel, track_index))
+        elif kind in (0xA0, 0xB0, 0xE0):
+            pos += 2
+        elif kind in (0xC0, 0xD0):
+            pos += 1
+        else:
+            raise MidiError('unexpected status byte 0x%02x in track %d' % (status, track_index))
+
+    # notes never released end with the track
+    for (channel, pitch), starts in held.items():
+        for start in starts:
+            notes.append((start, tick, pitch, channel, track_index))
+
+
+def parse_midi(data):
+    """Parse a Standard MIDI File. Returns (ticks_per_quarter, notes, tempos)."""
+    if data[:4] != b'MThd':
+        raise MidiError('not a Standard MIDI File')
+    header_len = struct.unpack('>I', data[4:8])[0]
+    fmt, ntracks, division = struct.unpack('>HHH', data[8:14])
+    if division & 0x8000:
+        raise MidiError('SMPTE time division is not supported')
+    if fmt > 1:
+        raise MidiError('MIDI format %d is not supported' % fmt)
+
+    notes = []
+    tempos = []
+    pos = 8 + header_len
+    track = 0
+    while pos + 8 <= len(data) and track < ntracks:
+        chunk = data[pos:pos + 4]
+        length = struct.unpack('>I', data[pos + 4:pos + 8])[0]
+        pos += 8
+        if chunk == b'MTrk':
+            parse_track(data, pos, min(pos + length, len(data)), track, notes, tempos)
+            track += 1
+        pos += length
+
+    notes.sort()
+    tempos.sort()
+    return division, notes, tempos
+
+
+# ============================================================================
+# Chart building
+# ============================================================================
+
+def pitch_to_lane(pitch, base, fold):
+    """Lane for a MIDI pitch, or None if it is out of range and not folded."""
+    lane = pitch - base
+    if 0 <= lane < NUM_LANES:
+        return lane
+    if not fold:
+        return None
+    # move by octaves into range; high C (12) is only reachable directly
+    return lane % 12
+
+
+def quantize(tick, grid):
+    return ((tick + grid // 2) // grid) * grid
+
+
+def build_chart(midi_tpq, notes, tempos, args):
+    """
+    Turn parsed MIDI into chart events.
+    Returns (events, report) where events are (tick, kind, lane, payload).
+    """
+    tpq = args.tpq
+    grid = max(1, tpq * 4 // args.grid)
+    sustain_min = tpq * 4 // args.sustain_min
+
+    def rescale(tick):
+        return (tick * tpq + midi_tpq // 2) // midi_tpq
+
+    events = []
+    dropped = 0
+    merged = 0
+    lane_busy = {} # lane -> tick the last note in it ends (chart ticks)
+    seen = set()   # (tick, lane) already used
+    for start, end, pitch, channel, track in notes:
+        if args.channel is not None and channel != args.channel - 1:
+            continue
+        if args.channel is None and channel == 9 and not args.drums:
+            continue # General MIDI percussion
+        if args.track is not None and track != args.track:
+            continue
+        lane = pitch_to_lane(pitch, args.base, args.fold)
+        if lane is None:
+            dropped += 1
+            continue
+        qstart = quantize(rescale(start), grid)
+        qend = quantize(rescale(end), grid)
+        if (qstart, lane) in seen or qstart < lane_busy.get(lane, 0):
+            merged += 1 # same key again before the last one finished
+            continue
+        seen.add((qstart, lane))
+        length = qend - qstart
+        if length >= sustain_min:
+            events.append((qstart, CHART_SUSTAIN, lane, length))
+            lane_busy[lane] = qend
+        else:
+            events.append((qstart, CHART_TAP, lane, None))
+            lane_busy[lane] = qstart + grid
+
+    first_tempo = DEFAULT_US_PER_QUARTER
+    for tick, us in tempos:
+        if tick == 0:
+            first_tempo = us
+        else:
+            events.append((quantize(rescale(tick), grid), CHART_TEMPO, 0, us))
+
+    # tempo changes sort before notes on the same tick so the notes use them
+    events.sort(key=lambda e: (e[0], 0 if e[1] == CHART_TEMPO else 1, e[2]))
+    last = 0
+    for tick, kind, lane, payload in events:
+        last = max(last, tick + (payload if kind == CHART_SUSTAIN else 0))
+    events.append((last + tpq * args.tail, CHART_END, 0, None))
+
+    report = {'dropped': dropped, 'merged': merged, 'first_tempo': first_tempo, 'grid': grid}
+    return events, report
+
+
+def tick_times(events, tpq, first_tempo):
+    """Microsecond time of every event, following the tempo map like chart_cursor."""
+    times = []
+    us_per_quarter = first_tempo
+    tempo_tick = 0
+    tempo_time = 0
+    for tick, kind, lane, payload in events:
+        t = tempo_time + (tick - tempo_tick) * us_per_quarter // tpq
+        times.append(t)
+        if kind == CHART_TEMPO:
+            tempo_tick, tempo_time, us_per_quarter = tick, t, payload
+    return times
+
+
+# ============================================================================
+# Output
+# ============================================================================
+
+def varint(value):
+    out = bytearray()
+    while True:
+        b = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return out
+
+
+def encode_chart(events, tpq, first_tempo):
+    data = bytearray(b'RBCH')
+    data += bytes([CHART_VERSION, 0])
+    data += struct.pack('<HI', tpq, first_tempo)
+    last = 0
+    for tick, kind, lane, payload in events:
+        data += varint(tick - last)
+        last = tick
+        data.append(kind | lane)
+        if kind in (CHART_SUSTAIN, CHART_TEMPO):
+            data += varint(payload)
+    return bytes(data)
+
+
+def write_header(path, name, data, comment):
+    guard = os.path.basename(path).upper().replace('.', '_').replace('-', '_')
+    with open(path, 'w') as f:
+        f.write('#ifndef %s\n#define %s\n\n' % (guard, guard))
+        for line in comment:
+            f.write('// %s\n' % line)
+        f.write('const unsigned char %s[%d] = {\n' % (name, len(data)))
+        rows = []
+        for i in range(0, len(data), 16):
+            rows.append('    ' + ', '.join('0x%02x' % b for b in data[i:i + 16]))
+        f.write(',\n'.join(rows))
+        f.write('\n};\n\n#endif\n')
+
+
+def density_report(events, times, tpq, report, nbytes):
+    notes = [(t, e) for t, e in zip(times, events) if e[1] in (CHART_TAP, CHART_SUSTAIN)]
+    end_us = times[-1]
+    print('chart: %d notes (%d sustains), %d tempo changes, %.1f s, %d bytes' % (
+        len(notes), sum(1 for t, e in notes if e[1] == CHART_SUSTAIN),
+        sum(1 for e in events if e[1] == CHART_TEMPO), end_us / 1e6, nbytes))
+    print('grid: %d ticks (%d per quarter), start tempo %.1f bpm' % (
+        report['grid'], tpq, 60e6 / report['first_tempo']))
+    if report['dropped']:
+        print('dropped %d notes outside the lanes (try --fold or --base)' % report['dropped'])
+    if report['merged']:
+        print('merged %d notes that repeated a key before it was released' % report['merged'])
+    if not notes:
+        return
+
+    # notes per second, in one second windows
+    seconds = int(end_us // 1000000) + 1
+    per_second = [0] * seconds
+    for t, e in notes:
+        per_second[int(t // 1000000)] += 1
+    print('notes/s: average %.2f, peak %d (at %d s)' % (
+        len(notes) / max(end_us / 1e6, 1e-6), max(per_second), per_second.index(max(per_second))))
+
+    # lanes
+    counts = [0] * NUM_LANES
+    for t, e in notes:
+        counts[e[2]] += 1
+    names = ['C', 'C#', 'D', 'D#', 'E', 'F', 'F#', 'G', 'G#', 'A', 'A#', 'B', 'C\'']
+    print('lane    ' + ' '.join('%4s' % n for n in names))
+    print('notes   ' + ' '.join('%4d' % c for c in counts))
+
+    # most notes on screen in one lane at once (vs the note pool's lane capacity)
+    worst = 0
+    for lane in range(NUM_LANES):
+        lane_times = [t for t, e in notes if e[2] == lane]
+        j = 0
+        for i in range(len(lane_times)):
+            while lane_times[i] - lane_times[j] > FALL_TIME_US:
+                j += 1
+            worst = max(worst, i - j + 1)
+    print('most notes on screen in one lane: %d (lane capacity %d)%s' % (
+        worst, NOTE_LANE_CAPACITY, '  ** too dense **' if worst > NOTE_LANE_CAPACITY else ''))
+
+    # ascii density plot, one column per second
+    if seconds > 1:
+        peak = max(per_second)
+        rows = 6
+        print('density (one column per second, peak %d notes/s)' % peak)
+        for r in range(rows, 0, -1):
+            print('  |' + ''.join('#' if c * rows >= r * peak and c else ' ' for c in per_second[:100]))
+        print('  +' + '-' * min(seconds, 100))
+
+
+# ============================================================================
+# Benchmark
+# ============================================================================
+
+def synthetic_midi(num_notes, tpq=480):
+    """A format 1 file with num_notes notes spread over 4 tracks, for --bench."""
+    tracks = []
+    per_track = num_notes // 4
+    for t in range(4):
+        body = bytearray()
+        if t == 0:
+            body += b'\x00\xff\x51\x03\x07\xa1\x20' # 120 bpm
+        for i in range(per_track):
+            pitch = 60 + (i * 7 + t * 3) % 13
+            body += varint_midi(tpq // 4 if i else 0) + bytes([0x90 | t, pitch, 100])
+            body += varint_midi(tpq // 8) + bytes([pitch, 0]) # running status note off
+        body += b'\x00\xff\x2f\x00'
+        tracks.append(b'MTrk' + struct.pack('>I', len(body)) + bytes(body))
+    return b'MThd' + struct.pack('>IHHH', 6, 1, len(tracks), tpq) + b''.join(tracks)
+
+
+def varint_midi(value):
+    out = [value & 0x7F]
+    value >>= 7
+    while value:
+        out.insert(0, (value & 0x7F) | 0x80)
+        value >>= 7
+    return bytes(out)
+
+
+def bench(data, args, repeats):
+    t0 = time.perf_counter()
+    for _ in range(repeats):
+        midi_tpq, notes, tempos = parse_midi(data)
+    t1 = time.perf_counter()
+    for _ in range(repeats):
+        events, report = build_chart(midi_tpq, notes, tempos, args)
+        encoded = encode_chart(events, args.tpq, report['first_tempo'])
+    t2 = time.perf_counter()
+    parse = (t1 - t0) / repeats
+    convert = (t2 - t1) / repeats
+    print('%d bytes, %d notes' % (len(data), len(notes)))
+    print('parse:   %8.2f ms  %8.2f MB/s  %10.0f notes/s' % (parse * 1e3, len(data) / parse / 1e6, len(notes) / parse))
+    print('convert: %8.2f ms  %10.0f notes/s  -> %d byte chart' % (convert * 1e3, len(notes) / convert, len(encoded)))
+
+
+# ============================================================================
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert a Standard MIDI File into a TemuPebbleBand2 note chart.')
+    parser.add_argument('midi_path', type=str, nargs='?', help='Path to the input .mid file.')
+    parser.add_argument('--header', type=str, help='Write a C header with the chart to this path.')
+    parser.add_argument('--bin', type=str, help='Write the raw binary chart to this path.')
+    parser.add_argument('--name', type=str, help='C array name (default: chart_<file name>).')
+    parser.add_argument('--base', type=int, default=60, help='MIDI pitch of lane 0 (default 60, middle C).')
+    parser.add_argument('--fold', action='store_true', help='Fold pitches outside the lanes in by octaves instead of dropping them.')
+    parser.add_argument('--tpq', type=int, default=480, help='Chart ticks per quarter note (default 480).')
+    parser.add_argument('--grid', type=int, default=16, help='Quantize to 1/GRID notes (default 16).')
+    parser.add_argument('--sustain-min', type=int, default=4, help='Notes at least 1/N long become sustains (default 4, a quarter).')
+    parser.add_argument('--tail', type=int, default=4, help='Quarters of silence after the last note before the song ends (default 4).')
+    parser.add_argument('--track', type=int, help='Only use this track (0-based).')
+    parser.add_argument('--channel', type=int, help='Only use this channel (1-16).')
+    parser.add_argument('--drums', action='store_true', help='Keep channel 10 (percussion).')
+    parser.add_argument('--bench', type=int, metavar='N', help='Time parsing N times (a synthetic 100k-note file if no MIDI path).')
+    args = parser.parse_args()
+
+    if args.bench:
+        data = open(args.midi_path, 'rb').read() if args.midi_path else synthetic_midi(100000)
+        bench(data, args, args.bench)
+        return
+    if not args.midi_path:
+        parser.error('midi_path is required')
+
+    data = open(args.midi_path, 'rb').read()
+    try:
+        midi_tpq, notes, tempos = parse_midi(data)
+    except (MidiError, IndexError, struct.error) as e:
+        sys.exit('%s: %s' % (args.midi_path, e if str(e) else 'truncated file'))
+
+    events, report = build_chart(midi_tpq, notes, tempos, args)
+    encoded = encode_chart(events, args.tpq, report['first_tempo'])
+    density_report(events, tick_times(events, args.tpq, report['first_tempo']), args.tpq, report, len(encoded))
+
+    base = os.path.splitext(os.path.basename(args.midi_path))[0]
+    name = args.name or 'chart_' + ''.join(c if c.isalnum() else '_' for c in base.lower())
+    if args.bin:
+        with open(args.bin, 'wb') as f:
+            f.write(encoded)
+        print(f'Chart saved to {args.bin}')
+    if args.header:
+        write_header(args.header, name, encoded, [
+            '%s -- converted from %s' % (name, os.path.basename(args.midi_path)),
+            'Binary chart, see chart.h for the format.'])
+        print(f'Chart saved to {args.header}')
+
+
+if __name__ == '__main__':
+    main()
+    # Example usage:
+    # python midi_to_chart.py song.mid --header ../TemuPebbleBand2/chart_song.h
+    # python midi_to_chart.py song.mid --fold --grid 8 --sustain-min 2
+    # python midi_to_chart.py --bench 5